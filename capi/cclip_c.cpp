@@ -0,0 +1,261 @@
+#include "cclip_c.h"
+#include "cclip.hpp"
+
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <string>
+#include <vector>
+
+struct cclip_schema
+{
+    // options_manager keeps the pointers it is given, so every string passed in is copied here first
+    std::deque<std::string> strings;
+    cclip::options_manager manager;
+    cclip::parse_result result;
+    std::string arg_buffer;
+    std::vector<size_t> arg_offsets;
+    std::vector<char *> args;
+    std::string error;
+    std::string help;
+    bool help_valid = false;
+
+    cclip_schema(const char *context, const char *description) : manager(this->keep(context), description == nullptr ? nullptr : this->keep(description))
+    {
+    }
+
+    const char *keep(const char *value)
+    {
+        this->strings.emplace_back(value == nullptr ? "" : value);
+        return this->strings.back().c_str();
+    }
+};
+
+namespace
+{
+    bool valid_option(const cclip_schema *schema, const int32_t option)
+    {
+        return schema != nullptr && option >= 0 && static_cast<size_t>(option) < schema->manager.get_options().size();
+    }
+
+    void set_string(const char *text, const size_t size, const char **value, size_t *length)
+    {
+        if (value != nullptr)
+        {
+            *value = text;
+        }
+        if (length != nullptr)
+        {
+            *length = size;
+        }
+    }
+}
+
+extern "C" {
+cclip_schema *cclip_schema_create(const char *context, const char *description)
+{
+    try
+    {
+        return new cclip_schema(context, description);
+    } catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void cclip_schema_destroy(cclip_schema *schema)
+{
+    delete schema;
+}
+
+int32_t cclip_add_option(cclip_schema *schema, const char *short_name, const char *long_name, const char *description, const int is_required, const int has_argument, const int executes_before_requires)
+{
+    if (schema == nullptr)
+    {
+        return -1;
+    }
+    try
+    {
+        const cclip::option_handle handle = schema->manager.add_option(schema->keep(short_name), schema->keep(long_name), schema->keep(description), is_required != 0, has_argument != 0, executes_before_requires != 0);
+        schema->help_valid = false;
+        return static_cast<int32_t>(handle.index);
+    } catch (const std::exception &e)
+    {
+        schema->error = e.what();
+        return -1;
+    }
+}
+
+int32_t cclip_add_choice_option(cclip_schema *schema, const char *short_name, const char *long_name, const char *description, const int is_required, const char *const *choices, const size_t choice_count)
+{
+    if (schema == nullptr || (choices == nullptr && choice_count > 0))
+    {
+        return -1;
+    }
+    try
+    {
+        std::vector<cclip::choice> values;
+        for (size_t i = 0; i < choice_count; ++i)
+        {
+            values.emplace_back(schema->keep(choices[i]), i);
+        }
+        const cclip::option_handle handle = schema->manager.add_choice_option(schema->keep(short_name), schema->keep(long_name), schema->keep(description), is_required != 0, std::move(values));
+        schema->help_valid = false;
+        return static_cast<int32_t>(handle.index);
+    } catch (const std::exception &e)
+    {
+        schema->error = e.what();
+        return -1;
+    }
+}
+
+int32_t cclip_add_positional(cclip_schema *schema, const char *name, const char *description, const int is_required)
+{
+    if (schema == nullptr)
+    {
+        return -1;
+    }
+    try
+    {
+        const cclip::positional_handle handle = schema->manager.add_positional(schema->keep(name), schema->keep(description), is_required != 0);
+        schema->help_valid = false;
+        return static_cast<int32_t>(handle.index);
+    } catch (const std::exception &e)
+    {
+        schema->error = e.what();
+        return -1;
+    }
+}
+
+cclip_status cclip_set_variadic(cclip_schema *schema, const char *name, const char *description, const int is_required)
+{
+    if (schema == nullptr)
+    {
+        return CCLIP_INVALID_ARGUMENT;
+    }
+    try
+    {
+        schema->manager.set_variadic(schema->keep(name), schema->keep(description), is_required != 0);
+        schema->help_valid = false;
+        return CCLIP_OK;
+    } catch (const std::exception &e)
+    {
+        schema->error = e.what();
+        return CCLIP_FAILURE;
+    }
+}
+
+cclip_status cclip_parse(cclip_schema *schema, const int argc, const char *const *argv)
+{
+    if (schema == nullptr || argc < 0 || (argv == nullptr && argc > 0))
+    {
+        return CCLIP_INVALID_ARGUMENT;
+    }
+    try
+    {
+        // The buffers keep their capacity between calls, so repeated parses of similar size do not allocate
+        schema->error.clear();
+        schema->arg_buffer.clear();
+        schema->arg_offsets.clear();
+        for (int i = 0; i < argc; ++i)
+        {
+            schema->arg_offsets.push_back(schema->arg_buffer.size());
+            schema->arg_buffer.append(argv[i] == nullptr ? "" : argv[i]).push_back('\0');
+        }
+        schema->args.clear();
+        for (const size_t offset: schema->arg_offsets)
+        {
+            schema->args.push_back(&schema->arg_buffer[offset]);
+        }
+        schema->manager.parse_into(argc, schema->args.data(), schema->result);
+        return CCLIP_OK;
+    } catch (const cclip::parse_error &e)
+    {
+        // Do not let the queries report options from a parse that failed
+        schema->result.reset(schema->manager.get_options().size());
+        schema->error = e.what();
+        return CCLIP_PARSE_ERROR;
+    } catch (const std::exception &e)
+    {
+        schema->result.reset(schema->manager.get_options().size());
+        schema->error = e.what();
+        return CCLIP_FAILURE;
+    }
+}
+
+const char *cclip_last_error(const cclip_schema *schema, size_t *length)
+{
+    if (schema == nullptr)
+    {
+        set_string("", 0, nullptr, length);
+        return "";
+    }
+    set_string(nullptr, schema->error.size(), nullptr, length);
+    return schema->error.c_str();
+}
+
+int cclip_is_present(const cclip_schema *schema, const int32_t option)
+{
+    return valid_option(schema, option) && schema->result.is_present({static_cast<std::uint32_t>(option)}) ? 1 : 0;
+}
+
+int cclip_get(const cclip_schema *schema, const int32_t option, const char **value, size_t *length)
+{
+    if (!valid_option(schema, option))
+    {
+        return 0;
+    }
+    const char *argument = schema->result.get({static_cast<std::uint32_t>(option)});
+    if (argument == nullptr)
+    {
+        return 0;
+    }
+    set_string(argument, std::strlen(argument), value, length);
+    return 1;
+}
+
+int32_t cclip_get_choice(const cclip_schema *schema, const int32_t option)
+{
+    return valid_option(schema, option) ? schema->result.get_choice_value({static_cast<std::uint32_t>(option)}) : -1;
+}
+
+size_t cclip_operand_count(const cclip_schema *schema)
+{
+    return schema == nullptr ? 0 : schema->result.get_operands().size();
+}
+
+int cclip_operand(const cclip_schema *schema, const size_t index, const char **value, size_t *length)
+{
+    if (schema == nullptr || index >= schema->result.get_operands().size())
+    {
+        return 0;
+    }
+    const char *operand = schema->result.get_operands()[index];
+    set_string(operand, std::strlen(operand), value, length);
+    return 1;
+}
+
+cclip_status cclip_help(cclip_schema *schema, const char **text, size_t *length)
+{
+    if (schema == nullptr)
+    {
+        return CCLIP_INVALID_ARGUMENT;
+    }
+    try
+    {
+        if (!schema->help_valid)
+        {
+            const char *help = schema->manager.get_help();
+            schema->help = help;
+            delete[] help;
+            schema->help_valid = true;
+        }
+        set_string(schema->help.c_str(), schema->help.size(), text, length);
+        return CCLIP_OK;
+    } catch (const std::exception &e)
+    {
+        schema->error = e.what();
+        return CCLIP_FAILURE;
+    }
+}
+}
@@ -0,0 +1,86 @@
+/*
+ * C interface to cclip, for calling the same command line definitions from other languages (Python ctypes/cffi, Rust, ...).
+ * Options are identified by the index returned when they are added. Strings returned by the accessors point into storage owned by the
+ * schema and stay valid until the next call to cclip_parse or cclip_schema_destroy; they are NUL-terminated and also come with their length.
+ * None of the query functions allocate.
+ */
+#ifndef CCLIP_C_H
+#define CCLIP_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#ifdef CCLIP_C_BUILD
+#define CCLIP_C_API __declspec(dllexport)
+#else
+#define CCLIP_C_API __declspec(dllimport)
+#endif
+#else
+#define CCLIP_C_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct cclip_schema cclip_schema;
+
+typedef enum cclip_status
+{
+    CCLIP_OK = 0,
+    /* The arguments did not match the schema, see cclip_last_error */
+    CCLIP_PARSE_ERROR = 1,
+    /* An argument of the call was invalid, e.g. an unknown option index */
+    CCLIP_INVALID_ARGUMENT = 2,
+    /* Any other failure, e.g. out of memory, see cclip_last_error */
+    CCLIP_FAILURE = 3
+} cclip_status;
+
+/* Create a schema, the strings are copied. Returns NULL on failure. */
+CCLIP_C_API cclip_schema *cclip_schema_create(const char *context, const char *description);
+
+CCLIP_C_API void cclip_schema_destroy(cclip_schema *schema);
+
+/* Add an option, see options_manager::add_option. Returns the index of the option, or -1 on failure. */
+CCLIP_C_API int32_t cclip_add_option(cclip_schema *schema, const char *short_name, const char *long_name, const char *description, int is_required, int has_argument, int executes_before_requires);
+
+/* Add an option whose argument must be one of the given values, which map to their position in the list. Returns the index of the option, or -1 on failure. */
+CCLIP_C_API int32_t cclip_add_choice_option(cclip_schema *schema, const char *short_name, const char *long_name, const char *description, int is_required, const char *const *choices, size_t choice_count);
+
+/* Add a named positional argument. Returns its position, or -1 on failure. */
+CCLIP_C_API int32_t cclip_add_positional(cclip_schema *schema, const char *name, const char *description, int is_required);
+
+/* Set the variadic argument that takes every operand after the named positional arguments. */
+CCLIP_C_API cclip_status cclip_set_variadic(cclip_schema *schema, const char *name, const char *description, int is_required);
+
+/* Parse arguments, argv[0] is the program name. The arguments are copied into the schema, the caller's strings can be freed afterwards.
+ * If the parse fails, every option reads as absent until the next successful parse. */
+CCLIP_C_API cclip_status cclip_parse(cclip_schema *schema, int argc, const char *const *argv);
+
+/* Get the message of the last error, or an empty string. */
+CCLIP_C_API const char *cclip_last_error(const cclip_schema *schema, size_t *length);
+
+/* Returns 1 if the option is present in the last parse, 0 otherwise. */
+CCLIP_C_API int cclip_is_present(const cclip_schema *schema, int32_t option);
+
+/* Get the argument of an option. Returns 1 and sets value/length if it has one, 0 otherwise. length may be NULL. */
+CCLIP_C_API int cclip_get(const cclip_schema *schema, int32_t option, const char **value, size_t *length);
+
+/* Get the position of the value given to a choice option in its list, or -1. */
+CCLIP_C_API int32_t cclip_get_choice(const cclip_schema *schema, int32_t option);
+
+/* Get the number of operands in the last parse. */
+CCLIP_C_API size_t cclip_operand_count(const cclip_schema *schema);
+
+/* Get an operand. Returns 1 and sets value/length if the index is in range, 0 otherwise. length may be NULL. */
+CCLIP_C_API int cclip_operand(const cclip_schema *schema, size_t index, const char **value, size_t *length);
+
+/* Render the help text. It is rendered once and cached until the schema changes. */
+CCLIP_C_API cclip_status cclip_help(cclip_schema *schema, const char **text, size_t *length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -10,520 +10,5799 @@
 #define CCLIP_VERSION "0.1.0"
 
 
-#ifndef OPTION_H
-#define OPTION_H
+#ifndef CONFIG_H
+#define CONFIG_H
+
+/**
+ * When set to 1 (the default) every definition is compiled inline into each translation unit that includes cclip.hpp.
+ * Set it to 0 and link against the cclip_static target to compile the implementation only once.
+ */
+#ifndef CCLIP_HEADER_ONLY
+#define CCLIP_HEADER_ONLY 1
+#endif
+
+#if CCLIP_HEADER_ONLY
+#define CCLIP_INLINE inline
+#else
+#define CCLIP_INLINE
+#endif
+
+#endif
+
+
+#ifndef ARG_STREAM_H
+#define ARG_STREAM_H
+
+#include <cstddef>
+#include <cstdio>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
 
 namespace cclip
 {
-    struct option
+    /**
+     * Reads arguments from a NUL- or newline-delimited stream, like xargs -0, e.g. for an --args-from option.
+     * Arguments are read through a fixed-size buffer and handed out one at a time as they arrive, so memory stays constant no matter how many there are.
+     * The file descriptor is read directly rather than through stdio, so an argument written to a pipe is handed out without waiting for
+     * the buffer to fill; nothing should be read from the FILE through stdio before.
+     */
+    class arg_stream
     {
+    public:
+        static constexpr size_t default_capacity = 64 * 1024;
+
+        class iterator
+        {
+        private:
+            arg_stream *stream;
+            std::string_view value;
+
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = std::string_view;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const std::string_view *;
+            using reference = const std::string_view &;
+
+            iterator() : stream(nullptr)
+            {
+            }
+
+            explicit iterator(arg_stream *stream) : stream(stream)
+            {
+                ++*this;
+            }
+
+            reference operator*() const
+            {
+                return this->value;
+            }
+
+            pointer operator->() const
+            {
+                return &this->value;
+            }
+
+            iterator &operator++()
+            {
+                if (!this->stream->next(this->value))
+                {
+                    this->stream = nullptr;
+                }
+                return *this;
+            }
+
+            bool operator==(const iterator &other) const
+            {
+                return this->stream == other.stream;
+            }
+
+            bool operator!=(const iterator &other) const
+            {
+                return this->stream != other.stream;
+            }
+        };
+
+    private:
+        std::FILE *file;
+        bool owns_file;
+        char delimiter;
+        std::vector<char> buffer;
+        size_t begin_offset;
+        size_t end_offset;
+        bool at_end;
+
+        size_t read_some(char *data, size_t count);
+
+    public:
         /**
-         * The short name of the option (e.g. -h) minus the dash (-).
-         */
-        const char *short_name;
-        /**
-         * The long name of the option (e.g. --help) minus the dashes (--).
+         * Read arguments from an open file. The file is not closed by the stream.
+         * @param file the file to read from, e.g. stdin
+         * @param delimiter the character separating arguments, '\0' or '\n'
+         * @param capacity the size of the buffer, which is also the maximum length of one argument
          */
-        const char *long_name;
+        explicit arg_stream(std::FILE *file, char delimiter = '\0', size_t capacity = default_capacity);
+
+        arg_stream(arg_stream &&other) noexcept;
+
+        arg_stream(const arg_stream &) = delete;
+
+        arg_stream &operator=(const arg_stream &) = delete;
+
+        arg_stream &operator=(arg_stream &&) = delete;
+
+        ~arg_stream();
+
         /**
-         * The description of the option.
+         * Open a file to read arguments from.
+         * @param path the path of the file, or - for stdin
+         * @param delimiter the character separating arguments, '\0' or '\n'
+         * @param capacity the size of the buffer, which is also the maximum length of one argument
+         * @return the stream
+         * @throws std::runtime_error if the file cannot be opened
          */
-        const char *description;
+        static arg_stream open(const char *path, char delimiter = '\0', size_t capacity = default_capacity);
+
         /**
-         * Whether or not the option is required.
+         * Read the next argument. In newline mode empty lines are skipped and a trailing carriage return is removed.
+         * @param arg set to the argument, it is NUL-terminated and only valid until the next call
+         * @return false once the stream has no more arguments
+         * @throws std::runtime_error if an argument does not fit in the buffer or the stream cannot be read
          */
-        bool is_required;
+        bool next(std::string_view &arg);
+
+        iterator begin()
+        {
+            return iterator(this);
+        }
+
+        iterator end()
+        {
+            return iterator();
+        }
+    };
+}
+#endif
+
+
+#ifndef CALLBACK_H
+#define CALLBACK_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace cclip
+{
+    template<typename Signature>
+    class callback;
+
+    /**
+     * A copyable wrapper for any function object, lambda or function pointer, like std::function.
+     * Handlers are stored as callbacks so the headers do not have to include <functional>, which is one of the most expensive standard headers to compile.
+     * @tparam R the return type
+     * @tparam Args the parameter types
+     */
+    template<typename R, typename... Args>
+    class callback<R(Args...)>
+    {
+    private:
+        void *target;
+        R (*invoke_target)(void *target, Args... args);
+        void *(*copy_target)(const void *target);
+        void (*destroy_target)(void *target);
+
+    public:
+        callback() noexcept : target(nullptr), invoke_target(nullptr), copy_target(nullptr), destroy_target(nullptr)
+        {
+        }
+
+        callback(std::nullptr_t) noexcept : callback()
+        {
+        }
+
+        template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, callback> && !std::is_member_pointer_v<std::decay_t<F> > && std::is_invocable_r_v<R, std::decay_t<F> &, Args...> > >
+        callback(F &&function) : callback()
+        {
+            using stored = std::decay_t<F>;
+            if constexpr (std::is_pointer_v<stored>)
+            {
+                if (function == nullptr)
+                {
+                    return;
+                }
+            }
+            this->target = new stored(std::forward<F>(function));
+            this->invoke_target = [](void *target, Args... args) -> R {
+                return static_cast<R>((*static_cast<stored *>(target))(std::forward<Args>(args)...));
+            };
+            this->copy_target = [](const void *target) -> void * {
+                return new stored(*static_cast<const stored *>(target));
+            };
+            this->destroy_target = [](void *target) {
+                delete static_cast<stored *>(target);
+            };
+        }
+
+        callback(const callback &other) : target(other.target == nullptr ? nullptr : other.copy_target(other.target)), invoke_target(other.invoke_target), copy_target(other.copy_target), destroy_target(other.destroy_target)
+        {
+        }
+
+        callback(callback &&other) noexcept : target(other.target), invoke_target(other.invoke_target), copy_target(other.copy_target), destroy_target(other.destroy_target)
+        {
+            other.target = nullptr;
+        }
+
+        callback &operator=(callback other) noexcept
+        {
+            std::swap(this->target, other.target);
+            std::swap(this->invoke_target, other.invoke_target);
+            std::swap(this->copy_target, other.copy_target);
+            std::swap(this->destroy_target, other.destroy_target);
+            return *this;
+        }
+
+        ~callback()
+        {
+            if (this->target != nullptr)
+            {
+                this->destroy_target(this->target);
+            }
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return this->target != nullptr;
+        }
+
         /**
-         * Whether or not the option has an argument.
+         * Call the wrapped function.
+         * @throws std::logic_error if the callback is empty
          */
-        bool has_argument;
+        R operator()(Args... args) const
+        {
+            if (this->target == nullptr)
+            {
+                throw std::logic_error("Called an empty callback.");
+            }
+            return this->invoke_target(this->target, std::forward<Args>(args)...);
+        }
+    };
+}
+#endif
+
+
+#ifndef PARSE_ERROR_H
+#define PARSE_ERROR_H
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cclip
+{
+    /**
+     * Thrown by options_manager::parse_into when the arguments do not match the schema.
+     * The message is the same one parse prints before exiting.
+     */
+    class parse_error : public std::runtime_error
+    {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    /**
+     * Thrown when an argument looks like an option but is not in the schema.
+     * It carries the closest option names, which are also listed in the message.
+     */
+    class unknown_option_error : public parse_error
+    {
+    private:
+        std::vector<std::string> suggestions;
+
+    public:
+        unknown_option_error(const std::string &message, std::vector<std::string> suggestions) : parse_error(message), suggestions(std::move(suggestions))
+        {
+        }
+
         /**
-         * Whether or not the option executes before it requires any other options.
-         * This means that if required options are not present but this is, the missing required options will be ignored.
-         * This is great for help and version options.
+         * Get the closest option names, with their dashes, closest first.
+         * @return the suggestions, empty if no option name is close enough
          */
-        bool executes_before_requires;
+        [[nodiscard]] const std::vector<std::string> &get_suggestions() const
+        {
+            return this->suggestions;
+        }
+    };
+}
+#endif
+
+
+#ifndef OPERAND_SPAN_H
+#define OPERAND_SPAN_H
+
+#include <cstddef>
+
+namespace cclip
+{
+    /**
+     * A view of the operands (the arguments that are not options) of a parse.
+     * It points into the argv that was parsed, so the operands are never copied; parse moves them to the front of argv, right after the program name.
+     */
+    class operand_span
+    {
+    private:
+        char **first;
+        size_t count;
+
+    public:
+        constexpr operand_span() : first(nullptr), count(0)
+        {
+        }
+
+        constexpr operand_span(char **first, const size_t count) : first(first), count(count)
+        {
+        }
+
+        [[nodiscard]] constexpr char *const *begin() const
+        {
+            return this->first;
+        }
+
+        [[nodiscard]] constexpr char *const *end() const
+        {
+            return this->first + this->count;
+        }
+
+        [[nodiscard]] constexpr size_t size() const
+        {
+            return this->count;
+        }
+
+        [[nodiscard]] constexpr bool empty() const
+        {
+            return this->count == 0;
+        }
+
+        [[nodiscard]] constexpr const char *operator[](const size_t index) const
+        {
+            return this->first[index];
+        }
+
         /**
-         * The argument of the option.
+         * Get the operands from an offset onwards.
+         * @param offset the number of operands to skip
+         * @return the remaining operands, or an empty span if there are not that many
          */
-        char *argument;
+        [[nodiscard]] constexpr operand_span subspan(const size_t offset) const
+        {
+            return offset >= this->count ? operand_span(this->first + this->count, 0) : operand_span(this->first + offset, this->count - offset);
+        }
     };
 }
 #endif
 
 
-#include <algorithm>
-#include <cstring>
+#ifndef OPTION_HANDLE_H
+#define OPTION_HANDLE_H
+
+#include <cstdint>
+
+namespace cclip
+{
+    /**
+     * A reference to an option returned by options_manager::add_option.
+     * It is the position of the option in the schema, so looking an option up by handle is an array index instead of a string search.
+     */
+    struct option_handle
+    {
+        std::uint32_t index;
+
+        bool operator==(const option_handle &other) const
+        {
+            return this->index == other.index;
+        }
+
+        bool operator!=(const option_handle &other) const
+        {
+            return this->index != other.index;
+        }
+    };
+
+    /**
+     * A reference to a named positional argument returned by options_manager::add_positional.
+     * It is the position of the operand it refers to.
+     */
+    struct positional_handle
+    {
+        std::uint32_t index;
+    };
+}
+#endif
+
+
+#ifndef PARSE_RESULT_H
+#define PARSE_RESULT_H
+
+#include <cstddef>
+#include <cstdint>
 #include <vector>
-#include <iostream>
-#include <sstream>
+
+
 
 
 namespace cclip
 {
-    class options_manager
+    /**
+     * The options found by a parse, indexed by option handle.
+     * Presence is kept as a bitset and arguments as a flat array, so queries never touch the option names.
+     */
+    class parse_result
     {
     private:
-        const char *context;
-        std::vector<option *> options;
-        std::vector<option *> present_options;
-        std::vector<const char *> example_usages;
-        const char *version;
-        const char *description;
-        std::string command_name;
+        std::vector<std::uint64_t> present;
+        std::vector<char *> arguments;
+        std::vector<int> choice_values;
+        operand_span operands;
+        // Scratch space for the arguments parse moves in front of the operands, kept to reuse its capacity
+        std::vector<char *> displaced;
 
-        option *get_option_from_global_list(const std::string &name);
+        friend class options_manager;
 
     public:
         /**
-         * Constructor for options_manager class.
-         *
-         * @param context The context of the options manager.
-         * @param description The description of the options manager.
+         * Clear the result and size it for a schema.
+         * @param option_count the number of options in the schema
          */
-        explicit options_manager(const char *context, const char *description = nullptr);
+        void reset(size_t option_count);
 
         /**
-         * Add an example usage to the options manager.
-         * @param example_usage the example usage to add
+         * Mark an option as present.
+         * @param index the index of the option in the schema
+         * @param argument the argument of the option, or nullptr if it has none
+         * @param choice_value the id of the value of a choice option, or -1
          */
-        void add_example_usage(const char *example_usage);
+        void set(std::uint32_t index, char *argument = nullptr, int choice_value = -1);
 
         /**
-         * Set the version of the options manager.
-         *
-         * @param version the version string to set (e.g. "1.0.0")
+         * Set the operands of the parse.
+         * @param operands the operands, in the argv that was parsed
          */
-        void set_version(const char *version);
+        void set_operands(operand_span operands);
 
         /**
-         * Get the version of the options manager.
-         *
-         * @return the version string
+         * Check if the option is present.
+         * @param handle the option
+         * @return whether or not the option is present
          */
-        const char *get_version();
+        [[nodiscard]] bool is_present(const option_handle handle) const
+        {
+            return handle.index / 64 < this->present.size() && (this->present[handle.index / 64] >> (handle.index % 64) & 1) != 0;
+        }
 
         /**
-         * Get the version of the options manager.
-         *
-         * @return the version string
+         * Get the argument of the option.
+         * @param handle the option
+         * @return the argument, or nullptr if the option is not present or has no argument
          */
-        [[nodiscard]] char *get_version() const;
+        [[nodiscard]] char *get(const option_handle handle) const
+        {
+            return handle.index < this->arguments.size() ? this->arguments[handle.index] : nullptr;
+        }
 
         /**
-         * Print the version of the options manager to the standard output.
+         * Get the id of the value given to a choice option.
+         * @param handle the option
+         * @return the id, or -1 if the option is not present or is not a choice option
          */
-        void print_version() const;
+        [[nodiscard]] int get_choice_value(const option_handle handle) const
+        {
+            return handle.index < this->choice_values.size() ? this->choice_values[handle.index] : -1;
+        }
 
         /**
-         * Print examples of how to use the options manager.
+         * Get the number of options in the schema the result was parsed with.
+         * @return the number of options
          */
-        void print_examples() const;
+        [[nodiscard]] size_t get_option_count() const
+        {
+            return this->arguments.size();
+        }
 
         /**
-         * Add an option to the options manager.
-         * @param short_name the short name of the option (e.g. -h) minus the dash (-)
-         * @param long_name the long name of the option (e.g. --help) minus the dashes (--)
-         * @param description the description of the option
-         * @param is_required whether or not the option is required
-         * @param has_argument whether or not the option has an argument
-         * @param executes_before_requires  Whether or not the option executes before it requires any other options. This means that if required options are not present but this is, the missing required options will be ignored. This is great for help and version options.
-         * @return the option that was added
+         * Get the presence bitset, bit i of word i / 64 is set if the option with index i is present.
+         * @return the bitset
          */
-        option *add_option(const char *short_name, const char *long_name, const char *description, bool is_required, bool has_argument, bool executes_before_requires = false);
+        [[nodiscard]] const std::vector<std::uint64_t> &get_presence() const
+        {
+            return this->present;
+        }
 
         /**
-         * Parse the command line arguments.
-         * @param argc the number of arguments
-         * @param argv the arguments
+         * Get the operands, the arguments that are not options or option arguments, in the order they were given.
+         * @return a view into the argv that was parsed
          */
-        void parse(int argc, char **argv);
+        [[nodiscard]] operand_span get_operands() const
+        {
+            return this->operands;
+        }
+    };
+}
+#endif
+
+
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include <cstddef>
+#include <iosfwd>
+
 
+
+
+
+namespace cclip
+{
+    class options_manager;
+
+    /**
+     * Runs many invocations in one process by reading command lines from a stream, e.g. stdin or a pipe.
+     * Each command line is split like a shell would (whitespace, quotes and backslashes), parsed against the schema without exiting,
+     * and handed to the application. The next lines are split and parsed on a background thread while the current one is handled; they are
+     * read on the calling thread, ahead of time only while the stream holds buffered input, so a command never waits for the next line.
+     */
+    class batch_runner
+    {
+    public:
+        struct command
+        {
+            /**
+             * The 1-based position of the command line in the input.
+             */
+            size_t line;
+            /**
+             * The number of arguments, including an empty program name in argv[0].
+             */
+            int argc;
+            /**
+             * The arguments, only valid during the call to the handler.
+             */
+            char **argv;
+            /**
+             * The parsed options, only valid during the call to the handler.
+             */
+            const parse_result &result;
+        };
+
+        using command_handler = callback<void(const command &)>;
+        using error_handler = callback<void(size_t line, const parse_error &error)>;
+
+    private:
+        const options_manager &schema;
+        char delimiter;
+
+    public:
         /**
-         * Print the help message to stdout.
+         * Create a runner. The schema must outlive the runner.
+         * @param schema the options each command line may contain
+         * @param delimiter the character separating command lines, '\n' or '\0'
          */
-        void print_help(bool print_examples = true) const;
+        explicit batch_runner(const options_manager &schema, char delimiter = '\n');
 
         /**
-         * Get the help message. This is useful if you want to print the help message to a file or something.<br>
-         * <b style="color: #f81c1c;"><i>Make sure to delete the returned string when you're done with it.</i></b>
-         * @return the help message
+         * Read command lines until the end of the input and dispatch each one. Blank lines are skipped.
+         * If the command handler throws, reading stops and the exception is rethrown.
+         * @param input the stream to read command lines from
+         * @param on_command called on the calling thread for every command line that parsed
+         * @param on_error called on the calling thread for every command line that did not parse, with the error parse_into threw (e.g. an
+         * unknown_option_error with its suggestions), the error is printed to stderr if this is empty
+         * @return the number of command lines that were dispatched to on_command
          */
-        [[nodiscard]] const char *get_help() const;
+        size_t run(std::istream &input, const command_handler &on_command, const error_handler &on_error = {}) const;
+    };
+}
+#endif
+
+
+#ifndef OPTION_SINK_H
+#define OPTION_SINK_H
+
+
+
+namespace cclip
+{
+    /**
+     * Receives the options as parse_into recognizes them, in the order they were given, see binding.
+     */
+    class option_sink
+    {
+    public:
+        virtual ~option_sink() = default;
 
         /**
-         * Check if the option is present in the arguments.
-         * @param name the short or long name of the option
-         * @return whether or not the option is present
+         * Called once for every option in the arguments.
+         * @param handle the option
+         * @param argument the argument of the option, or nullptr if it has none
+         * @param choice_value the id of the value of a choice option, or -1
+         * @throws parse_error to reject the value, which fails the parse
          */
-        [[nodiscard]] bool is_present(const std::string &name) const;
+        virtual void accept(option_handle handle, const char *argument, int choice_value) = 0;
+    };
+}
+#endif
+
 
+#ifndef CHOICE_TABLE_H
+#define CHOICE_TABLE_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+
+namespace cclip
+{
+    struct choice
+    {
         /**
-         * Get the option by name.
-         * @param name the short or long name of the option
-         * @return the option
+         * The value as it is typed on the command line (e.g. json).
          */
-        option *get_option(const std::string &name);
+        const char *name;
+        /**
+         * The id the value maps to, usually an enum value.
+         */
+        int value;
+
+        template<typename T>
+        constexpr choice(const char *name, T value) : name(name), value(static_cast<int>(value))
+        {
+        }
+    };
+
+    /**
+     * A perfect-hash table of the values a choice option accepts.
+     * The table is built once when the option is added, so a lookup during parsing is one hash and one string compare.
+     */
+    class choice_table
+    {
+    private:
+        std::vector<choice> choices;
+        std::vector<std::int32_t> slots;
+        std::uint32_t seed;
+        std::uint32_t mask;
 
+        static std::uint32_t hash(std::string_view value, std::uint32_t seed);
+
+    public:
         /**
-         * Builds a PowerShell script snippet for autocomplete feature.
-         *
-         * This method constructs a PowerShell script snippet that can be used as a
-         * completion script for cclip-example command. The script snippet registers
-         * an argument completer for the command, which provides autocompletion for
-         * command options.
-         *
-         * The constructed script snippet iterates over the list of options in the
-         * options_manager object and adds their short names and long names to the
-         * list of options. The short names are enclosed in single quotes followed by a
-         * hyphen, and the long names are preceded by two hyphens. The list of options
-         * is then joined as a string, with each option separated by a comma and a space.
-         * The trailing comma and space are removed.
-         *
-         * Finally, the script block is created, which takes three parameters: the
-         * commandName, the wordToComplete, and the cursorPosition. The script block
-         * assigns the constructed list of options to a variable called $options.
-         * It then filters the options using the wordToComplete and checks for a partial
-         * match with the options in the list. For each matching option, a
-         * System.Management.Automation.CompletionResult object is created with the
-         * option as the display text, the option as the completion text, 'ParameterName'
-         * as the completion type, and the option as the tooltip. The completion results
-         * are output as the result of the script block.
-         *
-         * @return The PowerShell script snippet as a C-string.
+         * Build the table, searching for a seed that places every value in its own slot.
+         * @param choices the allowed values and the ids they map to
+         * @throws std::invalid_argument if the same value is listed twice
          */
-        char *build_autocomplete_ps1() const;
+        explicit choice_table(std::vector<choice> choices);
+
+        /**
+         * Find an allowed value.
+         * @param value the value given on the command line
+         * @return the matching choice, or nullptr if the value is not allowed
+         */
+        [[nodiscard]] const choice *find(const char *value) const;
+
+        /**
+         * Find an allowed value that is not NUL-terminated, e.g. a token in a line.
+         * @param value the value given on the command line
+         * @return the matching choice, or nullptr if the value is not allowed
+         */
+        [[nodiscard]] const choice *find(std::string_view value) const;
+
+        /**
+         * Get the allowed values in the order they were declared.
+         * @return the allowed values
+         */
+        [[nodiscard]] const std::vector<choice> &get_choices() const;
     };
 }
+#endif
 
 
-#include <filesystem>
-#include <iostream>
+#ifndef CONSTRAINT_SET_H
+#define CONSTRAINT_SET_H
 
-inline cclip::options_manager::options_manager(const char *context, const char *description)
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace cclip
 {
-    this->context = context;
-    this->description = description;
-    this->version = nullptr;
+    /**
+     * Rules between options, such as "--out requires --format" or "exactly one of --a, --b, --c", compiled into bitmasks over option indices.
+     * Every rule has the same shape: when all of its trigger options are present, the number of its group options that are present must be within a range.
+     * The masks of all rules are stored back to back, so checking them is one pass of ANDs and popcounts over the presence bitset.
+     */
+    class constraint_set
+    {
+    private:
+        struct rule
+        {
+            size_t offset;
+            size_t words;
+            std::uint32_t min_count;
+            std::uint32_t max_count;
+            std::string message;
+        };
+
+        std::vector<std::uint64_t> masks;
+        std::vector<rule> rules;
+
+    public:
+        /**
+         * Add a rule.
+         * @param trigger the indices of the options that must all be present for the rule to apply, none to always apply it
+         * @param group the indices of the options that are counted
+         * @param min_count the minimum number of group options that must be present
+         * @param max_count the maximum number of group options that may be present
+         * @param message the error to report when the rule is violated
+         */
+        void add(const std::vector<std::uint32_t> &trigger, const std::vector<std::uint32_t> &group, std::uint32_t min_count, std::uint32_t max_count, std::string message);
+
+        /**
+         * Check every rule against a presence bitset.
+         * @param presence bit i of word i / 64 is set if the option with index i is present
+         * @param errors the message of every violated rule is appended to it, one per line
+         * @return false if any rule is violated
+         */
+        bool check(const std::vector<std::uint64_t> &presence, std::string &errors) const;
+
+        [[nodiscard]] bool empty() const
+        {
+            return this->rules.empty();
+        }
+    };
+}
+#endif
+
+
+#ifndef DEFAULT_VALUE_H
+#define DEFAULT_VALUE_H
+
+#include <string>
+
+
+
+namespace cclip
+{
+    /**
+     * The value an option falls back to when it is not given, either fixed or computed.
+     * A computed value is only computed the first time it is needed, and at most once even if it is needed from several threads at the same time.
+     */
+    class default_value
+    {
+    private:
+        const char *value;
+        callback<std::string()> compute;
+        const char *label;
+        int choice_value;
+        // The once_flag lives in the source file, so this header does not need <mutex>
+        struct lazy_state;
+        lazy_state *state;
+        mutable std::string computed;
+
+    public:
+        /**
+         * A fixed default value.
+         * @param value the value, it is also shown in the help
+         * @param choice_value the id the value maps to if the option is a choice option, otherwise -1
+         */
+        explicit default_value(const char *value, int choice_value = -1);
+
+        /**
+         * A computed default value.
+         * @param compute the function computing the value, called at most once
+         * @param label the text shown for the value in the help (e.g. number of CPUs), or nullptr to not show it
+         */
+        default_value(callback<std::string()> compute, const char *label);
+
+        default_value(const default_value &) = delete;
+
+        default_value &operator=(const default_value &) = delete;
+
+        ~default_value();
+
+        /**
+         * Get the value, computing it on the first call.
+         * @return the value, valid as long as the default_value
+         * @throws anything the compute function throws, in which case the next call tries again
+         */
+        [[nodiscard]] const char *get() const;
+
+        /**
+         * Get the text to show in the help, without computing the value.
+         * @return the fixed value, the label of a computed value, or nullptr
+         */
+        [[nodiscard]] const char *get_label() const;
+
+        /**
+         * Get the id the fixed value maps to.
+         * @return the id, or -1 if the option is not a choice option or the value is computed
+         */
+        [[nodiscard]] int get_choice_value() const
+        {
+            return this->choice_value;
+        }
+    };
+}
+#endif
+
+
+#ifndef NAME_TABLE_H
+#define NAME_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+
+namespace cclip
+{
+    /**
+     * Maps option names to option indices, with open addressing over one flat array of slots.
+     * A lookup is one hash and usually one string compare, and the table only needs the headers the rest of cclip already uses.
+     */
+    class name_table
+    {
+    private:
+        struct slot
+        {
+            std::string_view name;
+            std::uint32_t index;
+        };
+
+        std::vector<slot> slots;
+        size_t count = 0;
+
+        static std::uint32_t hash(std::string_view name);
+
+        void grow();
+
+    public:
+        /**
+         * Add a name. The characters are not copied, they must outlive the table.
+         * @param name the name, it must not be empty
+         * @param index the index of the option
+         * @return false if the name was already added, in which case it keeps its index
+         */
+        bool insert(std::string_view name, std::uint32_t index);
+
+        /**
+         * Find a name.
+         * @param name the name
+         * @return the index of the option, or -1 if there is no option with that name
+         */
+        [[nodiscard]] std::int32_t find(std::string_view name) const;
+    };
+}
+#endif
+
+
+#ifndef OPTION_H
+#define OPTION_H
+
+#include <cstdint>
+
+namespace cclip
+{
+    class choice_table;
+    class default_value;
+
+    struct option
+    {
+        /**
+         * The short name of the option (e.g. -h) minus the dash (-).
+         */
+        const char *short_name;
+        /**
+         * The long name of the option (e.g. --help) minus the dashes (--).
+         */
+        const char *long_name;
+        /**
+         * The description of the option.
+         */
+        const char *description;
+        /**
+         * Whether or not the option is required.
+         */
+        bool is_required;
+        /**
+         * Whether or not the option has an argument.
+         */
+        bool has_argument;
+        /**
+         * Whether or not the option executes before it requires any other options.
+         * This means that if required options are not present but this is, the missing required options will be ignored.
+         * This is great for help and version options.
+         */
+        bool executes_before_requires;
+        /**
+         * The argument of the option.
+         */
+        char *argument;
+        /**
+         * The values the argument is restricted to, or nullptr if any value is accepted.
+         */
+        const choice_table *choices = nullptr;
+        /**
+         * The value used when the option is not given, or nullptr if there is none.
+         */
+        const default_value *defaults = nullptr;
+        /**
+         * The id of the choice the argument matched, or -1 if the option is not a choice option or was not given.
+         */
+        int choice_value = -1;
+        /**
+         * The position of the option in the schema, this is the index an option_handle refers to.
+         */
+        std::uint32_t index = 0;
+    };
+}
+#endif
+
+
+#ifndef POSITIONAL_H
+#define POSITIONAL_H
+
+namespace cclip
+{
+    struct positional
+    {
+        /**
+         * The name of the argument as it is shown in the help (e.g. source).
+         */
+        const char *name;
+        /**
+         * The description of the argument.
+         */
+        const char *description;
+        /**
+         * Whether or not the argument is required. For the variadic tail this means at least one operand.
+         */
+        bool is_required;
+        /**
+         * Whether or not this is the variadic tail that takes every remaining operand.
+         */
+        bool is_variadic;
+    };
+}
+#endif
+
+
+#ifndef SUGGESTION_INDEX_H
+#define SUGGESTION_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+
+namespace cclip
+{
+    struct suggestion
+    {
+        /**
+         * The name of the option minus the dashes.
+         */
+        const char *name;
+        /**
+         * Whether or not the name is a long name (--name) rather than a short one (-n).
+         */
+        bool is_long;
+        /**
+         * The index of the option in the schema.
+         */
+        std::uint32_t option;
+        /**
+         * The edit distance between the name and the unknown option.
+         */
+        size_t distance;
+    };
+
+    /**
+     * Finds the option names closest to a misspelled one.
+     * Each candidate is compared with the bit-parallel edit distance of Myers (as adapted by Hyyrö), which takes one pass of a few word
+     * operations per character. Candidates whose length or set of characters differs by more edits than allowed are skipped before that.
+     * The names are also indexed by their bigrams and trigrams: an edit changes at most one of a set of pieces of the misspelled name that
+     * do not overlap, so a name within k edits contains at least one of any k + 1 of them, and only the names listed under the k + 1 pieces
+     * with the fewest names are visited. Trigrams that span two words of a name are usually rare, which keeps that list short.
+     * A misspelled name too short for k + 1 bigrams, or whose pieces list more names than the nearby lengths hold, is compared with every
+     * name of a nearby length instead.
+     */
+    class suggestion_index
+    {
+    private:
+        struct entry
+        {
+            const char *name;
+            size_t length;
+            std::uint32_t option;
+            bool is_long;
+        };
+
+        // The size of the list is kept in the slot, so choosing the pieces to look up reads nothing but the table
+        struct gram_slot
+        {
+            std::uint32_t key;
+            std::uint32_t list;
+            std::uint32_t size;
+        };
+
+        // The length and character set are copied next to the entry, so the filtering passes read one dense array and nothing else
+        struct posting
+        {
+            std::uint64_t characters;
+            std::uint32_t entry;
+            std::uint32_t length;
+        };
+
+        /**
+         * The longest name that is indexed by its bigrams. Bigrams are only looked up for a misspelled name shorter than 12 characters, which
+         * matches names at most 3 characters longer.
+         */
+        static constexpr size_t max_bigram_length = 14;
+
+        std::vector<entry> entries;
+        /**
+         * The entries of each name length, in the order they were added.
+         */
+        std::vector<std::vector<posting> > buckets;
+        /**
+         * The entries whose name contains each bigram or trigram, sorted by length and then in the order they were added. Only the names
+         * up to max_bigram_length are listed under their bigrams.
+         */
+        std::vector<std::vector<posting> > postings;
+        /**
+         * Open addressing from bigram or trigram to posting list, at most half full. A slot is free when its key is 0, since no gram of a
+         * name contains a null character.
+         */
+        std::vector<gram_slot> gram_slots;
+
+        static std::uint32_t gram(const char *text, size_t size);
+
+        [[nodiscard]] size_t home(std::uint32_t key) const;
+
+        void place(const gram_slot &slot);
+
+        [[nodiscard]] size_t find_gram(std::uint32_t key) const;
+
+        void index_gram(std::uint32_t key, const posting &added);
+
+        static std::uint64_t character_set(const char *text, size_t length);
+
+        static size_t distance(const unsigned char *slots, const std::uint64_t *peq, const char *pattern, size_t pattern_length, const char *text, size_t text_length, size_t limit);
+
+    public:
+        /**
+         * Add an option name.
+         * @param name the name minus the dashes
+         * @param option the index of the option in the schema
+         * @param is_long whether or not the name is a long name
+         */
+        void add(const char *name, std::uint32_t option, bool is_long);
+
+        /**
+         * Find the names closest to a misspelled one, at most a third of its length and 1 to 3 edits away.
+         * Only the first 64 characters of the name are compared.
+         * @param name the misspelled name minus the dashes
+         * @param max_results the maximum number of suggestions
+         * @return the suggestions, closest first, with at most one per option
+         */
+        [[nodiscard]] std::vector<suggestion> find(std::string_view name, size_t max_results = 3) const;
+    };
+}
+#endif
+
+
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+
+namespace cclip
+{
+    /**
+     * Check that text is well-formed UTF-8: no stray continuation bytes, truncated sequences, overlong encodings, surrogates or code points above U+10FFFF.
+     * Runs of ASCII are checked 16 bytes at a time where SSE2 is available.
+     * @param text the text
+     * @return whether or not the text is valid UTF-8
+     */
+    bool is_valid_utf8(std::string_view text);
+
+    /**
+     * Get the number of terminal columns text takes up.
+     * East Asian wide characters and most emoji take two columns, combining marks, zero-width characters and control characters none, and everything else one.
+     * Each byte of an invalid sequence counts as one column, like the replacement character a terminal shows for it.
+     * @param text the UTF-8 text
+     * @return the width in columns
+     */
+    size_t display_width(std::string_view text);
+
+    namespace detail
+    {
+        /**
+         * Decode one code point and move past it.
+         * @param position the first byte of the code point, moved past it, or one byte on an invalid sequence
+         * @param end the end of the text
+         * @return the code point, or -1 if the sequence is invalid
+         */
+        std::int32_t decode_utf8(const unsigned char *&position, const unsigned char *end);
+
+        /**
+         * Get the number of terminal columns a code point takes up, see display_width.
+         * @param code_point the code point
+         * @return 0, 1 or 2
+         */
+        size_t code_point_width(std::int32_t code_point);
+    }
+}
+#endif
+
+
+#include <initializer_list>
+#include <iosfwd>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+namespace cclip
+{
+    class options_manager
+    {
+    private:
+        const char *context;
+        std::vector<option *> options;
+        std::vector<positional> positionals;
+        parse_result result;
+        std::vector<callback<void(const char *argument)> > handlers;
+        name_table names;
+        suggestion_index suggestions;
+        constraint_set constraints;
+        size_t parallel_threshold;
+        std::vector<const char *> example_usages;
+        const char *version;
+        const char *description;
+        std::string command_name;
+        bool utf8_validation;
+        size_t help_width;
+        std::vector<size_t> option_label_widths;
+        std::vector<size_t> positional_label_widths;
+        size_t label_column;
+
+        [[nodiscard]] option *get_option_from_global_list(const std::string &name) const;
+
+        void store_argument(const option *opt, const char *name, char *argument, parse_result &result) const;
+
+        /**
+         * The parse loop shared by parse, parse_into and config files.
+         * @param complete whether or not to also check required options, positional arguments and constraints; a config file only gives
+         * some of the options, so only its names and values are checked
+         */
+        bool parse_arguments(int argc, char **argv, parse_result &result, bool dispatch, option_sink *sink, bool complete) const;
+
+        [[nodiscard]] std::int32_t classify(const char *arg) const;
+
+        [[nodiscard]] std::vector<std::int32_t> classify_parallel(int argc, char **argv) const;
+
+        [[nodiscard]] static std::string help_label(const option &opt);
+
+        [[nodiscard]] static std::string help_label(const positional &slot);
+
+        void measure_option(std::uint32_t index);
+
+        void measure_positionals();
+
+        static void align_help_column(std::ostream &out, size_t &cursor, size_t column, size_t indent);
+
+        static void append_wrapped(std::ostream &out, std::string_view text, size_t &cursor, size_t indent, size_t width);
+
+        [[nodiscard]] static size_t terminal_width();
+
+        [[nodiscard]] std::string display_names(std::initializer_list<option_handle> handles) const;
+
+        friend class config_snapshot;
+        friend class event_stream;
+        friend class incremental_parser;
+
+    public:
+        /**
+         * Constructor for options_manager class.
+         *
+         * @param context The context of the options manager.
+         * @param description The description of the options manager.
+         */
+        explicit options_manager(const char *context, const char *description = nullptr);
+
+        // Options, choice tables and default values are owned through raw pointers, so an options_manager cannot be copied
+        options_manager(const options_manager &) = delete;
+
+        options_manager &operator=(const options_manager &) = delete;
+
+        /**
+         * Frees every option along with its choices and default value.
+         */
+        ~options_manager();
+
+        /**
+         * Add an example usage to the options manager.
+         * @param example_usage the example usage to add
+         */
+        void add_example_usage(const char *example_usage);
+
+        /**
+         * Set the version of the options manager.
+         *
+         * @param version the version string to set (e.g. "1.0.0")
+         */
+        void set_version(const char *version);
+
+        /**
+         * Get the version of the options manager.
+         *
+         * @return the version string
+         */
+        const char *get_version();
+
+        /**
+         * Get the version of the options manager.
+         *
+         * @return the version string
+         */
+        [[nodiscard]] char *get_version() const;
+
+        /**
+         * Print the version of the options manager to the standard output.
+         */
+        void print_version() const;
+
+        /**
+         * Print examples of how to use the options manager.
+         */
+        void print_examples() const;
+
+        /**
+         * Add an option to the options manager.
+         * @param short_name the short name of the option (e.g. -h) minus the dash (-)
+         * @param long_name the long name of the option (e.g. --help) minus the dashes (--)
+         * @param description the description of the option
+         * @param is_required whether or not the option is required
+         * @param has_argument whether or not the option has an argument
+         * @param executes_before_requires  Whether or not the option executes before it requires any other options. This means that if required options are not present but this is, the missing required options will be ignored. This is great for help and version options.
+         * @return a handle to the option that was added
+         */
+        option_handle add_option(const char *short_name, const char *long_name, const char *description, bool is_required, bool has_argument, bool executes_before_requires = false);
+
+        /**
+         * Add an option whose argument must be one of a fixed set of values.
+         * The value is validated while parsing and mapped to the id given for it, so it can be switched on instead of compared as a string.
+         * @param short_name the short name of the option (e.g. -f) minus the dash (-)
+         * @param long_name the long name of the option (e.g. --format) minus the dashes (--)
+         * @param description the description of the option
+         * @param is_required whether or not the option is required
+         * @param choices the allowed values and the ids they map to (e.g. {{"json", format::json}, {"xml", format::xml}})
+         * @return a handle to the option that was added
+         */
+        option_handle add_choice_option(const char *short_name, const char *long_name, const char *description, bool is_required, std::initializer_list<choice> choices);
+
+        /**
+         * Add an option whose argument must be one of a fixed set of values.
+         * Each value maps to its position in the list.
+         * @param short_name the short name of the option (e.g. -f) minus the dash (-)
+         * @param long_name the long name of the option (e.g. --format) minus the dashes (--)
+         * @param description the description of the option
+         * @param is_required whether or not the option is required
+         * @param choices the allowed values
+         * @return a handle to the option that was added
+         */
+        option_handle add_choice_option(const char *short_name, const char *long_name, const char *description, bool is_required, std::initializer_list<const char *> choices);
+
+        /**
+         * Add an option whose argument must be one of a fixed set of values, built at runtime.
+         * @param short_name the short name of the option (e.g. -f) minus the dash (-)
+         * @param long_name the long name of the option (e.g. --format) minus the dashes (--)
+         * @param description the description of the option
+         * @param is_required whether or not the option is required
+         * @param choices the allowed values and the ids they map to
+         * @return a handle to the option that was added
+         */
+        option_handle add_choice_option(const char *short_name, const char *long_name, const char *description, bool is_required, std::vector<choice> choices);
+
+        /**
+         * Add a named positional argument. Positional arguments take the operands (the arguments that are not options) in the order they were added.
+         * @param name the name of the argument as it is shown in the help (e.g. source)
+         * @param description the description of the argument
+         * @param is_required whether or not the argument is required
+         * @return a handle to the argument that was added
+         * @throws std::logic_error if the variadic argument was already set
+         */
+        positional_handle add_positional(const char *name, const char *description, bool is_required = true);
+
+        /**
+         * Set the variadic argument, which takes every operand after the named positional arguments.
+         * If positional arguments are added but no variadic argument is set, extra operands are an error.
+         * @param name the name of the argument as it is shown in the help (e.g. files)
+         * @param description the description of the argument
+         * @param is_required whether or not at least one operand is required
+         */
+        void set_variadic(const char *name, const char *description, bool is_required = false);
+
+        /**
+         * Set the value an option falls back to when it is not given, see get_or_default. It is shown in the help.
+         * @param handle the handle returned by add_option or add_choice_option
+         * @param value the value, for a choice option one of its values
+         * @throws std::invalid_argument if the handle does not belong to this options_manager, the value is null or not one of the choices
+         * @throws std::logic_error if the option has no argument
+         */
+        void set_default(option_handle handle, const char *value);
+
+        /**
+         * Set a computed value an option falls back to when it is not given, see get_or_default.
+         * It is only computed the first time it is needed, e.g. to not probe the system when the option is given. The help shows the label instead of computing it.
+         * @param handle the handle returned by add_option
+         * @param compute the function computing the value, called at most once
+         * @param label the text shown for the value in the help (e.g. number of CPUs), or nullptr to not show it
+         * @throws std::invalid_argument if the handle does not belong to this options_manager or compute is empty
+         * @throws std::logic_error if the option has no argument or is a choice option, whose default must be one of its values
+         */
+        void set_default(option_handle handle, callback<std::string()> compute, const char *label);
+
+        /**
+         * Require other options whenever an option is present, e.g. --out requires --format.
+         * Like required options, constraints are not checked if an option that executes before requires is present.
+         * @param handle the option
+         * @param required the options that must be present with it
+         * @throws std::invalid_argument if a handle does not belong to this options_manager
+         */
+        void add_requires(option_handle handle, std::initializer_list<option_handle> required);
+
+        /**
+         * Forbid other options whenever an option is present, e.g. --json conflicts with --table.
+         * @param handle the option
+         * @param conflicting the options that must not be present with it
+         * @throws std::invalid_argument if a handle does not belong to this options_manager
+         */
+        void add_conflicts(option_handle handle, std::initializer_list<option_handle> conflicting);
+
+        /**
+         * Require exactly one option of a group.
+         * @param group the options
+         * @throws std::invalid_argument if a handle does not belong to this options_manager
+         */
+        void add_one_of(std::initializer_list<option_handle> group);
+
+        /**
+         * Require at least one option of a group.
+         * @param group the options
+         * @throws std::invalid_argument if a handle does not belong to this options_manager
+         */
+        void add_any_of(std::initializer_list<option_handle> group);
+
+        /**
+         * Allow at most one option of a group, the options are mutually exclusive.
+         * @param group the options
+         * @throws std::invalid_argument if a handle does not belong to this options_manager
+         */
+        void add_at_most_one_of(std::initializer_list<option_handle> group);
+
+        /**
+         * Bind a handler to an option. During parse the handler is called as soon as the option is recognized, with its argument (or nullptr),
+         * so the options do not have to be checked one by one afterwards.
+         * If the option executes before requires (e.g. --help), parse stops right after calling its handler.
+         * @param handle the handle returned by add_option
+         * @param handler the function to call
+         * @throws std::invalid_argument if the handle does not belong to this options_manager
+         */
+        void on(option_handle handle, callback<void(const char *argument)> handler);
+
+        /**
+         * Bind a member setter to an option, see on(option_handle, callback).
+         * @param handle the handle returned by add_option
+         * @param target the object to call the setter on, it must outlive the options_manager
+         * @param setter the member function to call with the argument (or nullptr)
+         * @throws std::invalid_argument if the handle does not belong to this options_manager
+         */
+        template<typename T>
+        void on(const option_handle handle, T &target, void (T::*setter)(const char *argument))
+        {
+            this->on(handle, [&target, setter](const char *argument) { (target.*setter)(argument); });
+        }
+
+        /**
+         * Parse the command line arguments.
+         * Handlers bound with on() are called in the order the options appear. If parsing fails after a handler ran, the error is still printed and the program exits.
+         * @param argc the number of arguments
+         * @param argv the arguments
+         * @return false if the handler of an option that executes before requires stopped the parse early, true otherwise
+         */
+        bool parse(int argc, char **argv);
+
+        /**
+         * Parse the command line arguments into a separate result without printing or exiting.
+         * The options_manager itself is not modified, so this can be called from several threads at once.
+         * @param argc the number of arguments
+         * @param argv the arguments, the first one is the program name and is skipped
+         * @param result the result to fill, it is reset first
+         * @throws parse_error if the arguments do not match the schema
+         */
+        void parse_into(int argc, char **argv, parse_result &result) const;
+
+        /**
+         * Parse the command line arguments into a separate result, handing each option to a sink as it is recognized.
+         * @param argc the number of arguments
+         * @param argv the arguments, the first one is the program name and is skipped
+         * @param result the result to fill, it is reset first
+         * @param sink receives the options in the order they were given
+         * @throws parse_error if the arguments do not match the schema or the sink rejects a value
+         */
+        void parse_into(int argc, char **argv, parse_result &result, option_sink &sink) const;
+
+        /**
+         * Set the number of arguments above which parsing classifies the arguments on several threads before resolving them in order.
+         * This only pays off for very long argument lists, such as hundreds of thousands of file names.
+         * @param threshold the number of arguments, the default is 65536
+         */
+        void set_parallel_threshold(size_t threshold);
+
+        /**
+         * Check that option arguments and operands are valid UTF-8 while parsing, which fails the parse otherwise.
+         * event_stream reports them as invalid_utf8 errors and incremental_parser as invalid_utf8 tokens. This is off by default.
+         * @param enabled whether or not to validate
+         */
+        void set_utf8_validation(bool enabled);
+
+        /**
+         * Set the width the help is laid out for. Descriptions are aligned in a column after the option names and wrapped to this width.
+         * @param columns the width in terminal columns, or 0 to use the COLUMNS environment variable or the width of the terminal, falling back to 80
+         */
+        void set_help_width(size_t columns);
+
+        /**
+         * Print the help message to stdout.
+         */
+        void print_help(bool print_examples = true) const;
+
+        /**
+         * Get the help message. This is useful if you want to print the help message to a file or something.<br>
+         * <b style="color: #f81c1c;"><i>Make sure to delete the returned string when you're done with it.</i></b>
+         * @return the help message
+         */
+        [[nodiscard]] const char *get_help() const;
+
+        /**
+         * Check if the option is present in the arguments.
+         * @param name the short or long name of the option
+         * @return whether or not the option is present
+         */
+        [[nodiscard]] bool is_present(const std::string &name) const;
+
+        /**
+         * Get the option by name.
+         * @param name the short or long name of the option
+         * @return the option
+         */
+        option *get_option(const std::string &name);
+
+        /**
+         * Get the id of the value given to a choice option.
+         * @tparam T the enum or integer type the ids were declared with
+         * @param name the short or long name of the option
+         * @param fallback the value to return if the option is not present and has no default
+         * @return the id of the value, of the default value, or the fallback
+         */
+        template<typename T = int>
+        T get_choice(const std::string &name, T fallback = T{})
+        {
+            const option *opt = this->find_option(name);
+            return opt == nullptr ? fallback : this->get_choice<T>(option_handle{opt->index}, fallback);
+        }
+
+        /**
+         * Check if the option is present in the arguments.
+         * @param handle the handle returned by add_option
+         * @return whether or not the option is present
+         */
+        [[nodiscard]] bool is_present(const option_handle handle) const
+        {
+            return this->result.is_present(handle);
+        }
+
+        /**
+         * Get the argument of the option.
+         * @param handle the handle returned by add_option
+         * @return the argument, or nullptr if the option is not present or has no argument
+         */
+        [[nodiscard]] const char *get(const option_handle handle) const
+        {
+            return this->result.get(handle);
+        }
+
+        /**
+         * Get the argument of the option, or its default value if it was not given.
+         * @param handle the handle returned by add_option
+         * @return the argument, the default value, or nullptr if the option has neither
+         */
+        [[nodiscard]] const char *get_or_default(option_handle handle) const;
+
+        /**
+         * Get the argument of the option in a separate result, or its default value if it was not given.
+         * @param result a result filled by parse_into
+         * @param handle the handle returned by add_option
+         * @return the argument, the default value, or nullptr if the option has neither
+         */
+        [[nodiscard]] const char *get_or_default(const parse_result &result, option_handle handle) const;
+
+        /**
+         * Get the operand given for a named positional argument.
+         * @param handle the handle returned by add_positional
+         * @return the operand, or nullptr if it was not given
+         */
+        [[nodiscard]] const char *get(positional_handle handle) const;
+
+        /**
+         * Get every operand, the arguments that are not options or option arguments, in the order they were given.
+         * Everything after a -- argument is an operand. The span points into the parsed argv, whose operands parse moved to the end, behind the options.
+         * @return the operands
+         */
+        [[nodiscard]] operand_span get_operands() const;
+
+        /**
+         * Get the operands that belong to the variadic argument, every operand after the named positional arguments.
+         * @return the operands
+         */
+        [[nodiscard]] operand_span get_variadic() const;
+
+        /**
+         * Get the positional arguments in the order they were added, with the variadic argument last.
+         * @return the positional arguments
+         */
+        [[nodiscard]] const std::vector<positional> &get_positionals() const;
+
+        /**
+         * Get the id of the value given to a choice option.
+         * @tparam T the enum or integer type the ids were declared with
+         * @param handle the handle returned by add_choice_option
+         * @param fallback the value to return if the option is not present and has no default
+         * @return the id of the value, of the default value, or the fallback
+         */
+        template<typename T = int>
+        [[nodiscard]] T get_choice(const option_handle handle, T fallback = T{}) const
+        {
+            int value = this->result.get_choice_value(handle);
+            if (value == -1 && handle.index < this->options.size() && this->options[handle.index]->defaults != nullptr)
+            {
+                value = this->options[handle.index]->defaults->get_choice_value();
+            }
+            return value == -1 ? fallback : static_cast<T>(value);
+        }
+
+        /**
+         * Find an option in the schema by name, whether or not it was given on the command line.
+         * @param name the short or long name of the option
+         * @return the option, or nullptr if there is no option with that name
+         */
+        [[nodiscard]] const option *find_option(std::string_view name) const;
+
+        /**
+         * Find the option names closest to a misspelled one, by edit distance.
+         * @param name the misspelled name minus the dashes
+         * @param max_results the maximum number of suggestions
+         * @return the suggestions, closest first
+         */
+        [[nodiscard]] std::vector<suggestion> suggest(const std::string &name, size_t max_results = 3) const;
+
+        /**
+         * Get every option in the schema, in the order they were added.
+         * The position of an option in this list is the index of its handle.
+         * @return the options
+         */
+        [[nodiscard]] const std::vector<option *> &get_options() const;
+
+        /**
+         * Get the result of the last parse.
+         * @return the parse result
+         */
+        [[nodiscard]] const parse_result &get_result() const;
+
+        /**
+         * Builds a PowerShell script snippet for autocomplete feature.
+         *
+         * This method constructs a PowerShell script snippet that can be used as a
+         * completion script for cclip-example command. The script snippet registers
+         * an argument completer for the command, which provides autocompletion for
+         * command options.
+         *
+         * The constructed script snippet iterates over the list of options in the
+         * options_manager object and adds their short names and long names to the
+         * list of options. The short names are enclosed in single quotes followed by a
+         * hyphen, and the long names are preceded by two hyphens. The list of options
+         * is then joined as a string, with each option separated by a comma and a space.
+         * The trailing comma and space are removed.
+         *
+         * Finally, the script block is created, which takes three parameters: the
+         * commandName, the wordToComplete, and the cursorPosition. The script block
+         * assigns the constructed list of options to a variable called $options.
+         * It then filters the options using the wordToComplete and checks for a partial
+         * match with the options in the list. For each matching option, a
+         * System.Management.Automation.CompletionResult object is created with the
+         * option as the display text, the option as the completion text, 'ParameterName'
+         * as the completion type, and the option as the tooltip. The completion results
+         * are output as the result of the script block.
+         *
+         * @return The PowerShell script snippet as a C-string.
+         */
+        char *build_autocomplete_ps1() const;
+    };
+}
+
+
+#ifndef BINDING_H
+#define BINDING_H
+
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+
+
+
+
+namespace cclip
+{
+    namespace detail
+    {
+        template<typename M>
+        void convert_argument(M &member, const char *argument, const int choice_value, const std::string &name)
+        {
+            if constexpr (std::is_same_v<M, bool>)
+            {
+                // A flag sets the member, an argument can also clear it
+                if (argument == nullptr || std::strcmp(argument, "true") == 0 || std::strcmp(argument, "1") == 0 || std::strcmp(argument, "yes") == 0 || std::strcmp(argument, "on") == 0)
+                {
+                    member = true;
+                } else if (std::strcmp(argument, "false") == 0 || std::strcmp(argument, "0") == 0 || std::strcmp(argument, "no") == 0 || std::strcmp(argument, "off") == 0)
+                {
+                    member = false;
+                } else
+                {
+                    throw parse_error("Invalid value for option: " + name + " (expected true or false)");
+                }
+            } else if constexpr (std::is_enum_v<M>)
+            {
+                member = static_cast<M>(choice_value);
+            } else if constexpr (std::is_integral_v<M>)
+            {
+                const char *end = argument + std::strlen(argument);
+                const auto [last, error] = std::from_chars(argument, end, member);
+                if (error == std::errc::result_out_of_range)
+                {
+                    throw parse_error("Invalid value for option: " + name + " (out of range)");
+                }
+                if (error != std::errc() || last != end)
+                {
+                    throw parse_error("Invalid value for option: " + name + " (expected an integer)");
+                }
+            } else if constexpr (std::is_floating_point_v<M>)
+            {
+                char *last = nullptr;
+                errno = 0;
+                if constexpr (std::is_same_v<M, float>)
+                {
+                    member = std::strtof(argument, &last);
+                } else if constexpr (std::is_same_v<M, double>)
+                {
+                    member = std::strtod(argument, &last);
+                } else
+                {
+                    member = std::strtold(argument, &last);
+                }
+                if (errno == ERANGE)
+                {
+                    throw parse_error("Invalid value for option: " + name + " (out of range)");
+                }
+                if (last == argument || *last != '\0')
+                {
+                    throw parse_error("Invalid value for option: " + name + " (expected a number)");
+                }
+            } else if constexpr (std::is_same_v<M, std::string> || std::is_same_v<M, std::string_view> || std::is_same_v<M, const char *>)
+            {
+                member = argument == nullptr ? "" : argument;
+            } else
+            {
+                static_assert(!sizeof(M), "Options can only be bound to bool, integer, floating point, enum and string members.");
+            }
+        }
+    }
+
+    /**
+     * Maps the options of a schema onto the members of a plain config struct, so parsing writes converted values straight into it
+     * instead of looking every option up and converting its argument afterwards.
+     * Members can be bool (set by a flag, or true/false/1/0/yes/no/on/off), integers, floating point numbers, enums (bound to a choice option and set to its id),
+     * std::string, or std::string_view and const char *, which point into argv.
+     * @tparam T the config struct
+     */
+    template<typename T>
+    class binding
+    {
+    private:
+        using writer = callback<void(T &target, const char *argument, int choice_value)>;
+
+        class target_sink : public option_sink
+        {
+        private:
+            const std::vector<writer> &fields;
+            T &target;
+
+        public:
+            target_sink(const std::vector<writer> &fields, T &target) : fields(fields), target(target)
+            {
+            }
+
+            void accept(const option_handle handle, const char *argument, const int choice_value) override
+            {
+                if (handle.index < this->fields.size() && this->fields[handle.index])
+                {
+                    this->fields[handle.index](this->target, argument, choice_value);
+                }
+            }
+        };
+
+        const options_manager &schema;
+        // Indexed by option, so each recognized option reaches its member without a lookup
+        std::vector<writer> fields;
+
+    public:
+        /**
+         * Create a binding. The schema must outlive the binding.
+         * @param schema the options to bind
+         */
+        explicit binding(const options_manager &schema) : schema(schema)
+        {
+        }
+
+        /**
+         * Bind an option to a member. Binding the same option again replaces the member it writes to.
+         * @param handle the handle returned by add_option or add_choice_option
+         * @param member the member to write, e.g. &config::level
+         * @return this binding, to chain calls
+         * @throws std::invalid_argument if the handle does not belong to the schema
+         * @throws std::logic_error if an enum member is bound to an option that is not a choice option, or a numeric member to an option without an argument
+         */
+        template<typename M>
+        binding &bind(const option_handle handle, M T::*member)
+        {
+            const std::vector<option *> &options = this->schema.get_options();
+            if (handle.index >= options.size())
+            {
+                throw std::invalid_argument("Binding refers to an option that does not exist.");
+            }
+            const option *opt = options[handle.index];
+            if constexpr (std::is_enum_v<M>)
+            {
+                if (opt->choices == nullptr)
+                {
+                    throw std::logic_error("Enum members can only be bound to choice options.");
+                }
+            } else if constexpr (std::is_arithmetic_v<M> && !std::is_same_v<M, bool>)
+            {
+                if (!opt->has_argument)
+                {
+                    throw std::logic_error("Numeric members can only be bound to options with an argument.");
+                }
+            }
+            std::string name = opt->long_name[0] ? "--" + std::string(opt->long_name) : "-" + std::string(opt->short_name);
+            if (this->fields.size() <= handle.index)
+            {
+                this->fields.resize(options.size());
+            }
+            this->fields[handle.index] = [member, name = std::move(name)](T &target, const char *argument, const int choice_value) {
+                detail::convert_argument(target.*member, argument, choice_value, name);
+            };
+            return *this;
+        }
+
+        /**
+         * Parse the command line arguments, writing the bound options into the target as they are recognized.
+         * Members of options that are not given keep their value, so the target can be initialized with the defaults.
+         * @param argc the number of arguments
+         * @param argv the arguments, the first one is the program name and is skipped
+         * @param target the struct to write to, it may be partially written if parsing fails
+         * @param result the result to fill, for operands and unbound options
+         * @throws parse_error if the arguments do not match the schema or a value cannot be converted
+         */
+        void parse(const int argc, char **argv, T &target, parse_result &result) const
+        {
+            target_sink sink(this->fields, target);
+            this->schema.parse_into(argc, argv, result, sink);
+        }
+
+        /**
+         * Parse the command line arguments, writing the bound options into the target as they are recognized.
+         * @param argc the number of arguments
+         * @param argv the arguments, the first one is the program name and is skipped
+         * @param target the struct to write to, it may be partially written if parsing fails
+         * @throws parse_error if the arguments do not match the schema or a value cannot be converted
+         */
+        void parse(const int argc, char **argv, T &target) const
+        {
+            parse_result result;
+            this->parse(argc, argv, target, result);
+        }
+    };
+}
+#endif
+
+
+#ifndef CANONICAL_H
+#define CANONICAL_H
+
+#include <cstdint>
+#include <vector>
+
+
+
+namespace cclip
+{
+    struct hash128
+    {
+        std::uint64_t low;
+        std::uint64_t high;
+
+        bool operator==(const hash128 &other) const
+        {
+            return this->low == other.low && this->high == other.high;
+        }
+
+        bool operator!=(const hash128 &other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    /*
+     * The canonical form of a parse result identifies the options by index rather than by how they were spelled, and lists them in index order
+     * rather than in the order they were given, so "-f x -V" and "-V --file x" are the same. Operands keep their order, since it is usually meaningful.
+     * It is read straight from the presence bitset and the argument table of the result.
+     * Only the options that were given are part of it, default values are not: an option left at its default and the same value given explicitly differ.
+     * The hashes read bytes as little-endian, so they are the same on every platform.
+     */
+
+    /**
+     * Hash the canonical form of a parse result.
+     * @param result the parse result
+     * @param seed a seed, e.g. to tell the results of different tools apart
+     * @return the 64-bit hash
+     */
+    [[nodiscard]] std::uint64_t canonical_hash64(const parse_result &result, std::uint64_t seed = 0);
+
+    /**
+     * Hash the canonical form of a parse result.
+     * @param result the parse result
+     * @param seed a seed, e.g. to tell the results of different tools apart
+     * @return the 128-bit hash
+     */
+    [[nodiscard]] hash128 canonical_hash128(const parse_result &result, std::uint64_t seed = 0);
+
+    /**
+     * Serialize the canonical form of a parse result.
+     * The format is a version byte, the number of present options, then for each one its index and its value length plus one (0 for no value)
+     * followed by the value, then the number of operands and each operand's length followed by the operand. All integers are LEB128 varints.
+     * @param result the parse result
+     * @param out the buffer the serialized form is appended to
+     */
+    void serialize_canonical(const parse_result &result, std::vector<unsigned char> &out);
+}
+#endif
+
+
+#ifndef CONFIG_SNAPSHOT_H
+#define CONFIG_SNAPSHOT_H
+
+#include <string>
+#include <vector>
+
+
+
+
+namespace cclip
+{
+    class options_manager;
+
+    /**
+     * An immutable set of options read from a config file.
+     * Each non-empty line of the file is either a bare option name (for flags) or "name = value", where name is the short or long name minus the dashes.
+     * Lines starting with # are comments.
+     */
+    class config_snapshot
+    {
+    private:
+        std::string buffer;
+        std::vector<char *> args;
+        parse_result result;
+
+    public:
+        /**
+         * Read and validate a config file. Only the option names and values are checked: required options, positional arguments and
+         * constraints are left to the command line.
+         * @param schema the options the file may contain
+         * @param path the path of the config file
+         * @throws parse_error if the file does not match the schema, including a line without a name, a bare name for an option that takes
+         * a value or a value for a flag
+         * @throws std::runtime_error if the file cannot be read
+         */
+        config_snapshot(const options_manager &schema, const std::string &path);
+
+        // The parse result points into buffer, so a snapshot stays where it was built
+        config_snapshot(const config_snapshot &) = delete;
+
+        config_snapshot &operator=(const config_snapshot &) = delete;
+
+        /**
+         * Check if the option is set in the config file.
+         * @param handle the handle returned by add_option
+         * @return whether or not the option is set
+         */
+        [[nodiscard]] bool is_present(const option_handle handle) const
+        {
+            return this->result.is_present(handle);
+        }
+
+        /**
+         * Get the value of the option.
+         * @param handle the handle returned by add_option
+         * @return the value, or nullptr if the option is not set or has no argument
+         */
+        [[nodiscard]] const char *get(const option_handle handle) const
+        {
+            return this->result.get(handle);
+        }
+
+        /**
+         * Get the id of the value given to a choice option.
+         * @tparam T the enum or integer type the ids were declared with
+         * @param handle the handle returned by add_choice_option
+         * @param fallback the value to return if the option is not set
+         * @return the id of the value, or the fallback
+         */
+        template<typename T = int>
+        [[nodiscard]] T get_choice(const option_handle handle, T fallback = T{}) const
+        {
+            const int value = this->result.get_choice_value(handle);
+            return value == -1 ? fallback : static_cast<T>(value);
+        }
+
+        /**
+         * Get the parsed options.
+         * @return the parse result
+         */
+        [[nodiscard]] const parse_result &get_result() const;
+    };
+}
+#endif
+
+
+#ifndef CONFIG_RELOADER_H
+#define CONFIG_RELOADER_H
+
+#include <cstddef>
+#include <exception>
+#include <string>
+
+
+
+
+namespace cclip
+{
+    class options_manager;
+
+    /**
+     * Keeps the latest valid snapshot of a config file and reloads it when the file changes.
+     * A reload parses the file off to the side and publishes it with a single atomic pointer swap, so readers never wait for it.
+     * Old snapshots are reclaimed once no reader holds them, which is tracked with hazard pointers.
+     */
+    class config_reloader
+    {
+    public:
+        /**
+         * The number of readers that can hold a snapshot at the same time, further readers spin until a slot frees up.
+         */
+        static constexpr size_t max_readers = 64;
+
+    private:
+        // The atomics, the lock and the watcher thread are defined in the source file, so this header does not need <atomic>, <mutex> or <thread>
+        struct hazard_slot;
+        struct shared_state;
+
+        const options_manager &schema;
+        std::string path;
+        shared_state *state;
+
+        void watch();
+
+        void reclaim();
+
+        void report(const std::exception &error) const;
+
+    public:
+        /**
+         * Keeps a snapshot alive while it is being read.
+         * Readers should hold it briefly (e.g. for one request) and read again to see newer snapshots.
+         */
+        class reader
+        {
+        private:
+            hazard_slot *slot;
+            const config_snapshot *snapshot;
+
+            friend class config_reloader;
+
+            reader(hazard_slot *slot, const config_snapshot *snapshot);
+
+        public:
+            reader(reader &&other) noexcept;
+
+            reader(const reader &) = delete;
+
+            reader &operator=(const reader &) = delete;
+
+            reader &operator=(reader &&) = delete;
+
+            ~reader();
+
+            const config_snapshot *operator->() const
+            {
+                return this->snapshot;
+            }
+
+            const config_snapshot &operator*() const
+            {
+                return *this->snapshot;
+            }
+        };
+
+        /**
+         * Load the config file. The schema must outlive the reloader.
+         * @param schema the options the file may contain
+         * @param path the path of the config file
+         * @throws parse_error if the file does not match the schema
+         * @throws std::runtime_error if the file cannot be read
+         */
+        config_reloader(const options_manager &schema, std::string path);
+
+        config_reloader(const config_reloader &) = delete;
+
+        config_reloader &operator=(const config_reloader &) = delete;
+
+        /**
+         * Stops watching and frees every snapshot, no reader may be alive at this point.
+         */
+        ~config_reloader();
+
+        /**
+         * Start watching the config file on a background thread, reloading it whenever it is written.
+         * This uses inotify on Linux and polls the modification time elsewhere.
+         */
+        void start();
+
+        /**
+         * Stop watching the config file.
+         */
+        void stop();
+
+        /**
+         * Reload the config file now.
+         * If the file is missing or invalid the current snapshot is kept and the error is reported.
+         * @return whether or not a new snapshot was published
+         */
+        bool reload();
+
+        /**
+         * Get the current snapshot. This never blocks on a reload.
+         * @return a reader that keeps the snapshot alive until it is destroyed
+         */
+        [[nodiscard]] reader read() const;
+
+        /**
+         * Set the function that is called when a reload fails, instead of printing the error to stderr.
+         * @param handler the function to call with the error
+         */
+        void on_error(callback<void(const std::exception &)> handler);
+    };
+}
+#endif
+
+
+#ifndef EVENT_STREAM_H
+#define EVENT_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
+
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#include <exception>
+#define CCLIP_HAS_COROUTINES 1
+#endif
+#endif
+
+namespace cclip
+{
+    class options_manager;
+
+    enum class event_kind
+    {
+        /**
+         * An option was recognized, with its argument if it takes one.
+         */
+        option,
+        /**
+         * An argument that is not an option or an option argument.
+         */
+        operand,
+        /**
+         * An argument that does not match the schema, see parse_event::error.
+         */
+        error
+    };
+
+    enum class event_error
+    {
+        none,
+        /**
+         * The argument looks like an option but no option has that name.
+         */
+        unknown_option,
+        /**
+         * The option takes an argument but it was the last one.
+         */
+        missing_argument,
+        /**
+         * The argument of a choice option is not one of its values.
+         */
+        invalid_value,
+        /**
+         * An operand or option argument is not valid UTF-8, only reported if the schema validates UTF-8.
+         */
+        invalid_utf8
+    };
+
+    /**
+     * One event of a pull parse. The views point into argv.
+     */
+    struct parse_event
+    {
+        event_kind kind = event_kind::operand;
+        event_error error = event_error::none;
+        /**
+         * The option, for option events, for missing_argument and invalid_value errors, and for invalid_utf8 errors in an option argument.
+         */
+        option_handle option{0};
+        /**
+         * The option as it was written (e.g. --format), for option and error events, empty for an invalid_utf8 error in an operand.
+         */
+        std::string_view name;
+        /**
+         * The argument of the option, the operand, or the rejected value of an invalid_value or invalid_utf8 error.
+         */
+        std::string_view value;
+        /**
+         * The id of the value of a choice option, or -1.
+         */
+        int choice_value = -1;
+    };
+
+    /**
+     * Parses arguments one event at a time, in the order they were given, instead of filling a parse_result.
+     * This is useful to apply options to something as they arrive. Nothing is allocated and argv is not modified.
+     * Unlike parse, errors are reported as events and parsing goes on after them, and required options and positional arguments are not checked.
+     */
+    class event_stream
+    {
+    public:
+        class iterator
+        {
+        private:
+            event_stream *stream;
+            parse_event event;
+
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = parse_event;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const parse_event *;
+            using reference = const parse_event &;
+
+            iterator() : stream(nullptr)
+            {
+            }
+
+            explicit iterator(event_stream *stream) : stream(stream)
+            {
+                ++*this;
+            }
+
+            reference operator*() const
+            {
+                return this->event;
+            }
+
+            pointer operator->() const
+            {
+                return &this->event;
+            }
+
+            iterator &operator++()
+            {
+                if (!this->stream->next(this->event))
+                {
+                    this->stream = nullptr;
+                }
+                return *this;
+            }
+
+            bool operator==(const iterator &other) const
+            {
+                return this->stream == other.stream;
+            }
+
+            bool operator!=(const iterator &other) const
+            {
+                return this->stream != other.stream;
+            }
+        };
+
+    private:
+        const options_manager &schema;
+        int argc;
+        const char *const *argv;
+        int position;
+        bool terminated;
+
+    public:
+        /**
+         * Create a stream over the arguments. The schema and argv must outlive the stream.
+         * @param schema the options the arguments may contain
+         * @param argc the number of arguments
+         * @param argv the arguments, the first one is the program name and is skipped
+         */
+        event_stream(const options_manager &schema, int argc, const char *const *argv);
+
+        /**
+         * Parse the next event.
+         * @param event set to the event
+         * @return false once every argument was parsed
+         */
+        bool next(parse_event &event);
+
+        iterator begin()
+        {
+            return iterator(this);
+        }
+
+        iterator end()
+        {
+            return iterator();
+        }
+    };
+
+    /**
+     * Parse arguments one event at a time, see event_stream.
+     * @param schema the options the arguments may contain
+     * @param argc the number of arguments
+     * @param argv the arguments, the first one is the program name and is skipped
+     * @return the events, to iterate with a range-based for loop
+     */
+    event_stream events(const options_manager &schema, int argc, const char *const *argv);
+
+#ifdef CCLIP_HAS_COROUTINES
+    /**
+     * A C++20 generator of parse events, see generate_events.
+     */
+    class event_generator
+    {
+    public:
+        struct promise_type
+        {
+            const parse_event *current = nullptr;
+            std::exception_ptr exception;
+
+            event_generator get_return_object()
+            {
+                return event_generator(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            std::suspend_always initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            std::suspend_always final_suspend() noexcept
+            {
+                return {};
+            }
+
+            std::suspend_always yield_value(const parse_event &event) noexcept
+            {
+                this->current = &event;
+                return {};
+            }
+
+            void return_void() noexcept
+            {
+            }
+
+            void unhandled_exception()
+            {
+                this->exception = std::current_exception();
+            }
+        };
+
+        class iterator
+        {
+        private:
+            std::coroutine_handle<promise_type> coroutine;
+
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = parse_event;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const parse_event *;
+            using reference = const parse_event &;
+
+            iterator() = default;
+
+            explicit iterator(const std::coroutine_handle<promise_type> coroutine) : coroutine(coroutine)
+            {
+                ++*this;
+            }
+
+            reference operator*() const
+            {
+                return *this->coroutine.promise().current;
+            }
+
+            pointer operator->() const
+            {
+                return this->coroutine.promise().current;
+            }
+
+            iterator &operator++()
+            {
+                this->coroutine.resume();
+                if (this->coroutine.done())
+                {
+                    const std::exception_ptr exception = this->coroutine.promise().exception;
+                    this->coroutine = nullptr;
+                    if (exception)
+                    {
+                        std::rethrow_exception(exception);
+                    }
+                }
+                return *this;
+            }
+
+            bool operator==(const iterator &other) const
+            {
+                return this->coroutine == other.coroutine;
+            }
+
+            bool operator!=(const iterator &other) const
+            {
+                return this->coroutine != other.coroutine;
+            }
+        };
+
+    private:
+        std::coroutine_handle<promise_type> coroutine;
+
+        explicit event_generator(const std::coroutine_handle<promise_type> coroutine) : coroutine(coroutine)
+        {
+        }
+
+    public:
+        event_generator(event_generator &&other) noexcept : coroutine(other.coroutine)
+        {
+            other.coroutine = nullptr;
+        }
+
+        event_generator(const event_generator &) = delete;
+
+        event_generator &operator=(const event_generator &) = delete;
+
+        event_generator &operator=(event_generator &&) = delete;
+
+        ~event_generator()
+        {
+            if (this->coroutine)
+            {
+                this->coroutine.destroy();
+            }
+        }
+
+        /**
+         * Start the generator, it can only be iterated once.
+         */
+        iterator begin()
+        {
+            return iterator(this->coroutine);
+        }
+
+        iterator end()
+        {
+            return iterator();
+        }
+    };
+
+    /**
+     * Parse arguments one event at a time as a C++20 generator, see event_stream.
+     * The events are produced lazily as the generator is resumed, and each one is only valid until the next.
+     * @param schema the options the arguments may contain
+     * @param argc the number of arguments
+     * @param argv the arguments, the first one is the program name and is skipped
+     * @return the generator
+     */
+    // Defined here rather than in the source file, so it does not depend on the language level the compiled library was built with
+    inline event_generator generate_events(const options_manager &schema, const int argc, const char *const *argv)
+    {
+        event_stream stream(schema, argc, argv);
+        parse_event event;
+        while (stream.next(event))
+        {
+            co_yield event;
+        }
+    }
+#endif
+}
+#endif
+
+
+#ifndef INCREMENTAL_PARSER_H
+#define INCREMENTAL_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+
+namespace cclip
+{
+    class options_manager;
+
+    /**
+     * Parses a command line as it is being typed, e.g. to show validation hints in an interactive console.
+     * The tokens and their classification are kept between edits, and an edit only re-tokenizes the text it touched and
+     * re-classifies tokens until the classification matches the previous one again. The tokens live in a gap buffer at the last edit,
+     * so typing does not shift or move the tokens after the cursor.
+     * Tokens are separated by whitespace.
+     */
+    class incremental_parser
+    {
+    public:
+        enum class token_kind
+        {
+            /**
+             * A token that is neither an option nor an argument.
+             */
+            operand,
+            /**
+             * The -- argument, every token after it is a literal.
+             */
+            terminator,
+            /**
+             * An operand after the -- argument, even if it starts with a dash.
+             */
+            literal,
+            /**
+             * A known option.
+             */
+            option,
+            /**
+             * The argument of the option before it.
+             */
+            argument,
+            /**
+             * An option that is not in the schema.
+             */
+            unknown_option,
+            /**
+             * An option that takes an argument but is the last token.
+             */
+            missing_argument,
+            /**
+             * An argument that is not one of the values its choice option accepts.
+             */
+            invalid_value,
+            /**
+             * An operand or argument that is not valid UTF-8, only if the schema validates UTF-8.
+             */
+            invalid_utf8,
+            /**
+             * A literal that is not valid UTF-8, only if the schema validates UTF-8.
+             */
+            invalid_utf8_literal
+        };
+
+        struct token
+        {
+            /**
+             * The offset of the token in the line.
+             */
+            size_t begin;
+            /**
+             * The length of the token in bytes.
+             */
+            size_t length;
+            token_kind kind;
+            /**
+             * The index of the option the token is or belongs to, or -1.
+             */
+            std::int32_t option;
+        };
+
+    private:
+        const options_manager &schema;
+        std::string line;
+        /**
+         * The tokens with a gap of unused entries at the last edit. Tokens in front of the gap store their offset from the start of the line,
+         * tokens behind it their offset from the end, so an edit does not change the tokens behind it.
+         */
+        std::vector<token> tokens;
+        size_t gap_begin;
+        size_t gap_end;
+        std::vector<std::uint32_t> counts;
+        /**
+         * One bit per option that appears in the line, kept in sync with counts so the schema's constraints can be checked.
+         */
+        std::vector<std::uint64_t> presence;
+        size_t error_count;
+        size_t missing_required;
+        size_t before_requires_present;
+        size_t operand_count;
+        size_t min_operands;
+        size_t max_operands;
+
+        [[nodiscard]] token &stored(size_t index);
+
+        [[nodiscard]] size_t begin_of(size_t index) const;
+
+        void move_gap(size_t index);
+
+        void tokenize(size_t begin, size_t end, std::vector<token> &out) const;
+
+        [[nodiscard]] token_kind classify(size_t index, std::int32_t &option) const;
+
+        void count(const token &t, int direction);
+
+    public:
+        /**
+         * Create a parser for an empty line. The schema must outlive the parser.
+         * @param schema the options the line may contain
+         */
+        explicit incremental_parser(const options_manager &schema);
+
+        /**
+         * Replace the whole line and parse it from scratch.
+         * @param line the new line
+         */
+        void set_line(const std::string &line);
+
+        /**
+         * Apply an edit to the line and update the parse state.
+         * @param offset the offset in the line where the edit starts
+         * @param erase_count the number of bytes removed at the offset
+         * @param insert the text inserted at the offset
+         */
+        void edit(size_t offset, size_t erase_count, const std::string &insert);
+
+        /**
+         * Get the current line.
+         * @return the line
+         */
+        [[nodiscard]] const std::string &get_line() const;
+
+        /**
+         * Get the number of tokens in the line.
+         * @return the number of tokens
+         */
+        [[nodiscard]] size_t get_token_count() const;
+
+        /**
+         * Get a token of the line.
+         * @param index the index of the token, less than get_token_count
+         * @return the token
+         */
+        [[nodiscard]] token get_token(size_t index) const;
+
+        /**
+         * Get a copy of the tokens of the line in order.
+         * @return the tokens
+         */
+        [[nodiscard]] std::vector<token> get_tokens() const;
+
+        /**
+         * Get a message describing a token error, in the same wording as parse.
+         * @param t the token
+         * @return the message, or an empty string if the token is valid
+         */
+        [[nodiscard]] std::string describe(const token &t) const;
+
+        /**
+         * Get the number of tokens with an error.
+         * @return the number of errors
+         */
+        [[nodiscard]] size_t get_error_count() const;
+
+        /**
+         * Check if the option appears in the line.
+         * @param handle the handle returned by add_option
+         * @return whether or not the option is present
+         */
+        [[nodiscard]] bool is_present(option_handle handle) const;
+
+        /**
+         * Check if the line would parse without errors, including required options and the schema's constraints.
+         * @return whether or not the line is valid
+         */
+        [[nodiscard]] bool is_valid() const;
+    };
+}
+#endif
+
+#if CCLIP_HEADER_ONLY
+
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <io.h>
+#endif
+
+CCLIP_INLINE cclip::arg_stream::arg_stream(std::FILE *file, const char delimiter, const size_t capacity) : file(file), owns_file(false), delimiter(delimiter), buffer(capacity + 1), begin_offset(0), end_offset(0), at_end(false)
+{
+}
+
+CCLIP_INLINE cclip::arg_stream::arg_stream(arg_stream &&other) noexcept : file(other.file), owns_file(other.owns_file), delimiter(other.delimiter), buffer(std::move(other.buffer)), begin_offset(other.begin_offset), end_offset(other.end_offset), at_end(other.at_end)
+{
+    other.file = nullptr;
+    other.owns_file = false;
+}
+
+CCLIP_INLINE cclip::arg_stream::~arg_stream()
+{
+    if (this->owns_file && this->file != nullptr)
+    {
+        std::fclose(this->file);
+    }
+}
+
+CCLIP_INLINE cclip::arg_stream cclip::arg_stream::open(const char *path, const char delimiter, const size_t capacity)
+{
+    if (std::strcmp(path, "-") == 0)
+    {
+        return arg_stream(stdin, delimiter, capacity);
+    }
+    std::FILE *file = std::fopen(path, "rb");
+    if (file == nullptr)
+    {
+        throw std::runtime_error("Unable to open argument file: " + std::string(path));
+    }
+    arg_stream stream(file, delimiter, capacity);
+    stream.owns_file = true;
+    return stream;
+}
+
+CCLIP_INLINE size_t cclip::arg_stream::read_some(char *data, const size_t count)
+{
+    // A short read returns whatever a pipe holds, where fread would wait until the buffer is full
+#if defined(__unix__) || defined(__APPLE__)
+    for (;;)
+    {
+        const ssize_t read = ::read(fileno(this->file), data, count);
+        if (read >= 0)
+        {
+            return static_cast<size_t>(read);
+        }
+        if (errno != EINTR)
+        {
+            throw std::runtime_error("Unable to read arguments");
+        }
+    }
+#elif defined(_WIN32)
+    const int read = _read(_fileno(this->file), data, static_cast<unsigned int>(std::min<size_t>(count, 1u << 30)));
+    if (read < 0)
+    {
+        throw std::runtime_error("Unable to read arguments");
+    }
+    return static_cast<size_t>(read);
+#else
+    const size_t read = std::fread(data, 1, count, this->file);
+    if (read == 0 && std::ferror(this->file))
+    {
+        throw std::runtime_error("Unable to read arguments");
+    }
+    return read;
+#endif
+}
+
+CCLIP_INLINE bool cclip::arg_stream::next(std::string_view &arg)
+{
+    // The last byte of the buffer is kept free so the final argument can be NUL-terminated too
+    const size_t capacity = this->buffer.size() - 1;
+    for (;;)
+    {
+        char *data = this->buffer.data();
+        const auto *found = static_cast<char *>(std::memchr(data + this->begin_offset, this->delimiter, this->end_offset - this->begin_offset));
+        size_t length;
+        if (found != nullptr)
+        {
+            length = found - (data + this->begin_offset);
+        } else if (this->at_end)
+        {
+            if (this->begin_offset == this->end_offset)
+            {
+                return false;
+            }
+            length = this->end_offset - this->begin_offset;
+        } else
+        {
+            // Move the partial argument to the front and fill the rest of the buffer
+            if (this->begin_offset > 0)
+            {
+                std::memmove(data, data + this->begin_offset, this->end_offset - this->begin_offset);
+                this->end_offset -= this->begin_offset;
+                this->begin_offset = 0;
+            }
+            if (this->end_offset == capacity)
+            {
+                throw std::runtime_error("Argument is longer than " + std::to_string(capacity) + " bytes");
+            }
+            const size_t read = this->read_some(data + this->end_offset, capacity - this->end_offset);
+            this->end_offset += read;
+            if (read == 0)
+            {
+                this->at_end = true;
+            }
+            continue;
+        }
+
+        char *start = data + this->begin_offset;
+        start[length] = '\0';
+        this->begin_offset = std::min(this->begin_offset + length + 1, this->end_offset);
+        if (this->delimiter == '\n')
+        {
+            if (length > 0 && start[length - 1] == '\r')
+            {
+                start[--length] = '\0';
+            }
+            if (length == 0)
+            {
+                continue;
+            }
+        }
+        arg = std::string_view(start, length);
+        return true;
+    }
+}
+
+
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace cclip
+{
+    namespace detail
+    {
+        struct batch_slot
+        {
+            size_t line = 0;
+            std::string text;
+            std::string buffer;
+            std::vector<size_t> offsets;
+            std::vector<char *> argv;
+            parse_result result;
+            bool parsed = false;
+            std::exception_ptr error;
+        };
+
+        // Read the next command line into the slot, skipping blank lines
+        CCLIP_INLINE bool read_command_line(std::istream &input, const char delimiter, batch_slot &slot, size_t &line)
+        {
+            while (std::getline(input, slot.text, delimiter))
+            {
+                ++line;
+                if (slot.text.find_first_not_of(" \t\r") != std::string::npos)
+                {
+                    slot.line = line;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Split a command line into NUL-terminated arguments the way a POSIX shell would, without expansions
+        CCLIP_INLINE void split_command_line(batch_slot &slot)
+        {
+            slot.buffer.clear();
+            slot.offsets.clear();
+            slot.buffer.push_back('\0'); // argv[0]
+            slot.offsets.push_back(0);
+
+            const std::string &text = slot.text;
+            size_t i = 0;
+            while (i < text.size())
+            {
+                while (i < text.size() && (text[i] == ' ' || text[i] == '\t' || text[i] == '\r'))
+                {
+                    ++i;
+                }
+                if (i >= text.size())
+                {
+                    break;
+                }
+                slot.offsets.push_back(slot.buffer.size());
+                char quote = 0;
+                for (; i < text.size(); ++i)
+                {
+                    const char c = text[i];
+                    if (quote == '\'')
+                    {
+                        if (c == '\'')
+                            quote = 0;
+                        else
+                            slot.buffer.push_back(c);
+                    } else if (c == '\\' && i + 1 < text.size() && (quote == 0 || text[i + 1] == '"' || text[i + 1] == '\\'))
+                    {
+                        slot.buffer.push_back(text[++i]);
+                    } else if (quote == '"')
+                    {
+                        if (c == '"')
+                            quote = 0;
+                        else
+                            slot.buffer.push_back(c);
+                    } else if (c == '\'' || c == '"')
+                    {
+                        quote = c;
+                    } else if (c == ' ' || c == '\t' || c == '\r')
+                    {
+                        break;
+                    } else
+                    {
+                        slot.buffer.push_back(c);
+                    }
+                }
+                slot.buffer.push_back('\0');
+            }
+
+            slot.argv.clear();
+            for (const size_t offset: slot.offsets)
+            {
+                slot.argv.push_back(&slot.buffer[offset]);
+            }
+        }
+    }
+}
+
+CCLIP_INLINE cclip::batch_runner::batch_runner(const options_manager &schema, const char delimiter) : schema(schema), delimiter(delimiter)
+{
+}
+
+CCLIP_INLINE size_t cclip::batch_runner::run(std::istream &input, const command_handler &on_command, const error_handler &on_error) const
+{
+    // Lines are read here and split and parsed on a worker thread while the handler of an earlier line runs. A line is only read ahead
+    // while the stream already holds buffered input, so a parsed command never waits for the next line to arrive, and nothing is left
+    // blocked on the stream when a handler throws. A few slots are recycled so their buffers are only allocated once
+    constexpr size_t slot_count = 4;
+    detail::batch_slot slots[slot_count];
+    std::vector<detail::batch_slot *> free_slots;
+    for (auto &slot: slots)
+    {
+        free_slots.push_back(&slot);
+    }
+    std::deque<detail::batch_slot *> in_flight; // read and not yet dispatched, in input order
+    std::deque<detail::batch_slot *> queued; // waiting for the worker
+    std::mutex mutex;
+    std::condition_variable slot_queued;
+    std::condition_variable slot_parsed;
+    bool stopping = false;
+
+    std::thread worker([&]
+    {
+        for (;;)
+        {
+            detail::batch_slot *slot;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                slot_queued.wait(lock, [&] { return stopping || !queued.empty(); });
+                if (stopping)
+                {
+                    break;
+                }
+                slot = queued.front();
+                queued.pop_front();
+            }
+
+            detail::split_command_line(*slot);
+            slot->error = nullptr;
+            try
+            {
+                this->schema.parse_into(static_cast<int>(slot->argv.size()), slot->argv.data(), slot->result);
+            } catch (const parse_error &)
+            {
+                slot->error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            slot->parsed = true;
+            slot_parsed.notify_one();
+        }
+    });
+
+    size_t line = 0;
+    bool input_done = false;
+    size_t dispatched = 0;
+    std::exception_ptr failure;
+    for (;;)
+    {
+        std::streambuf *buffered = input.rdbuf();
+        if (!input_done && !free_slots.empty() && (in_flight.empty() || (buffered != nullptr && buffered->in_avail() > 0)))
+        {
+            detail::batch_slot *slot = free_slots.back();
+            if (!detail::read_command_line(input, this->delimiter, *slot, line))
+            {
+                input_done = true;
+                continue;
+            }
+            free_slots.pop_back();
+            in_flight.push_back(slot);
+            std::lock_guard<std::mutex> lock(mutex);
+            slot->parsed = false;
+            queued.push_back(slot);
+            slot_queued.notify_one();
+            continue;
+        }
+        if (in_flight.empty())
+        {
+            break;
+        }
+
+        detail::batch_slot *slot = in_flight.front();
+        in_flight.pop_front();
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            slot_parsed.wait(lock, [slot] { return slot->parsed; });
+        }
+        try
+        {
+            if (slot->error)
+            {
+                // Rethrown so the handler gets the original error, e.g. an unknown_option_error with its suggestions
+                try
+                {
+                    std::rethrow_exception(slot->error);
+                } catch (const parse_error &e)
+                {
+                    if (on_error)
+                        on_error(slot->line, e);
+                    else
+                        std::cerr << "Line " << slot->line << ": " << e.what() << std::endl;
+                }
+            } else
+            {
+                on_command(command{slot->line, static_cast<int>(slot->argv.size()), slot->argv.data(), slot->result});
+                ++dispatched;
+            }
+        } catch (...)
+        {
+            failure = std::current_exception();
+            break;
+        }
+        free_slots.push_back(slot);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    slot_queued.notify_one();
+    worker.join();
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
+    return dispatched;
+}
+
+
+#include <bitset>
+#include <cstring>
+
+namespace cclip
+{
+    namespace detail
+    {
+        // Walks the canonical form of a result, feeding integers and byte ranges to a sink
+        template<typename Sink>
+        void write_canonical(const parse_result &result, Sink &sink)
+        {
+            const std::vector<std::uint64_t> &presence = result.get_presence();
+            size_t present = 0;
+            for (const std::uint64_t word: presence)
+            {
+                present += std::bitset<64>(word).count();
+            }
+            sink.integer(present);
+
+            for (size_t w = 0; w < presence.size(); ++w)
+            {
+                std::uint64_t bits = presence[w];
+                for (std::uint32_t bit = 0; bits != 0; ++bit, bits >>= 1)
+                {
+                    if ((bits & 1) == 0)
+                    {
+                        continue;
+                    }
+                    const auto index = static_cast<std::uint32_t>(w * 64 + bit);
+                    sink.integer(index);
+                    if (const char *value = result.get({index}); value != nullptr)
+                    {
+                        const size_t length = std::strlen(value);
+                        sink.integer(length + 1);
+                        sink.bytes(value, length);
+                    } else
+                    {
+                        sink.integer(0);
+                    }
+                }
+            }
+
+            const operand_span operands = result.get_operands();
+            sink.integer(operands.size());
+            for (const char *operand: operands)
+            {
+                const size_t length = std::strlen(operand);
+                sink.integer(length);
+                sink.bytes(operand, length);
+            }
+        }
+
+        class canonical_hasher
+        {
+        private:
+            std::uint64_t a;
+            std::uint64_t b;
+            std::uint64_t length;
+
+            static std::uint64_t rotate(const std::uint64_t value, const int bits)
+            {
+                return value << bits | value >> (64 - bits);
+            }
+
+            static std::uint64_t finish(std::uint64_t value)
+            {
+                // The murmur3 finalizer
+                value ^= value >> 33;
+                value *= 0xff51afd7ed558ccdULL;
+                value ^= value >> 33;
+                value *= 0xc4ceb9fe1a85ec53ULL;
+                value ^= value >> 33;
+                return value;
+            }
+
+            void word(const std::uint64_t value)
+            {
+                this->a = rotate((this->a ^ value) * 0x9e3779b97f4a7c15ULL, 31);
+                this->b = rotate((this->b + value) * 0xc2b2ae3d27d4eb4fULL, 29) ^ this->a;
+                ++this->length;
+            }
+
+        public:
+            explicit canonical_hasher(const std::uint64_t seed) : a(seed ^ 0x243f6a8885a308d3ULL), b(~seed ^ 0x13198a2e03707344ULL), length(0)
+            {
+            }
+
+            void integer(const std::uint64_t value)
+            {
+                this->word(value);
+            }
+
+            // Read as little-endian whatever the host is, so a hash can be compared across machines; compilers turn a full word into one load
+            static std::uint64_t load(const char *data, const size_t size)
+            {
+                std::uint64_t value = 0;
+                for (size_t i = 0; i < size; ++i)
+                {
+                    value |= std::uint64_t{static_cast<unsigned char>(data[i])} << (8 * i);
+                }
+                return value;
+            }
+
+            void bytes(const char *data, size_t size)
+            {
+                for (; size >= 8; data += 8, size -= 8)
+                {
+                    this->word(load(data, 8));
+                }
+                if (size > 0)
+                {
+                    this->word(load(data, size));
+                }
+            }
+
+            hash128 digest() const
+            {
+                const std::uint64_t low = finish(this->a ^ this->length);
+                const std::uint64_t high = finish(this->b + low);
+                return hash128{low, high};
+            }
+        };
+
+        class canonical_writer
+        {
+        private:
+            std::vector<unsigned char> &out;
+
+        public:
+            explicit canonical_writer(std::vector<unsigned char> &out) : out(out)
+            {
+            }
+
+            void integer(std::uint64_t value)
+            {
+                for (; value >= 0x80; value >>= 7)
+                {
+                    this->out.push_back(static_cast<unsigned char>(value | 0x80));
+                }
+                this->out.push_back(static_cast<unsigned char>(value));
+            }
+
+            void bytes(const char *data, const size_t size)
+            {
+                this->out.insert(this->out.end(), data, data + size);
+            }
+        };
+    }
+}
+
+CCLIP_INLINE std::uint64_t cclip::canonical_hash64(const parse_result &result, const std::uint64_t seed)
+{
+    return canonical_hash128(result, seed).low;
+}
+
+CCLIP_INLINE cclip::hash128 cclip::canonical_hash128(const parse_result &result, const std::uint64_t seed)
+{
+    detail::canonical_hasher hasher(seed);
+    detail::write_canonical(result, hasher);
+    return hasher.digest();
+}
+
+CCLIP_INLINE void cclip::serialize_canonical(const parse_result &result, std::vector<unsigned char> &out)
+{
+    out.push_back(1); // format version
+    detail::canonical_writer writer(out);
+    detail::write_canonical(result, writer);
+}
+
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+CCLIP_INLINE std::uint32_t cclip::choice_table::hash(const std::string_view value, const std::uint32_t seed)
+{
+    // FNV-1a with the seed folded into the offset basis
+    std::uint32_t h = 2166136261u ^ seed;
+    for (const char c: value)
+    {
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    h ^= h >> 16;
+    return h;
+}
+
+CCLIP_INLINE cclip::choice_table::choice_table(std::vector<choice> choices) : choices(std::move(choices)), seed(0), mask(0)
+{
+    for (size_t i = 0; i < this->choices.size(); ++i)
+    {
+        for (size_t j = i + 1; j < this->choices.size(); ++j)
+        {
+            if (std::strcmp(this->choices[i].name, this->choices[j].name) == 0)
+            {
+                throw std::invalid_argument("Duplicate choice value: " + std::string(this->choices[i].name));
+            }
+        }
+    }
+
+    size_t size = 1;
+    while (size < this->choices.size() * 2)
+    {
+        size <<= 1;
+    }
+
+    // Try seeds until every value lands in its own slot, growing the table if a size turns out to be too tight
+    for (;; size <<= 1)
+    {
+        this->mask = static_cast<std::uint32_t>(size - 1);
+        for (this->seed = 0; this->seed < 256; ++this->seed)
+        {
+            this->slots.assign(size, -1);
+            bool collided = false;
+            for (size_t i = 0; i < this->choices.size() && !collided; ++i)
+            {
+                std::int32_t &slot = this->slots[hash(this->choices[i].name, this->seed) & this->mask];
+                collided = slot != -1;
+                slot = static_cast<std::int32_t>(i);
+            }
+            if (!collided)
+            {
+                return;
+            }
+        }
+    }
+}
+
+CCLIP_INLINE const cclip::choice *cclip::choice_table::find(const char *value) const
+{
+    return value == nullptr ? nullptr : this->find(std::string_view(value));
+}
+
+CCLIP_INLINE const cclip::choice *cclip::choice_table::find(const std::string_view value) const
+{
+    if (this->slots.empty())
+    {
+        return nullptr;
+    }
+    const std::int32_t slot = this->slots[hash(value, this->seed) & this->mask];
+    if (slot == -1 || value != this->choices[slot].name)
+    {
+        return nullptr;
+    }
+    return &this->choices[slot];
+}
+
+CCLIP_INLINE const std::vector<cclip::choice> &cclip::choice_table::get_choices() const
+{
+    return this->choices;
+}
+
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+struct alignas(64) cclip::config_reloader::hazard_slot
+{
+    std::atomic<const config_snapshot *> pointer{nullptr};
+    std::atomic<bool> claimed{false};
+};
+
+struct cclip::config_reloader::shared_state
+{
+    std::atomic<const config_snapshot *> current{nullptr};
+    hazard_slot hazards[max_readers];
+    std::vector<const config_snapshot *> retired;
+    std::mutex reload_mutex;
+    std::atomic<bool> running{false};
+    std::thread watcher;
+    callback<void(const std::exception &)> error_handler;
+};
+
+CCLIP_INLINE cclip::config_reloader::reader::reader(hazard_slot *slot, const config_snapshot *snapshot) : slot(slot), snapshot(snapshot)
+{
+}
+
+CCLIP_INLINE cclip::config_reloader::reader::reader(reader &&other) noexcept : slot(other.slot), snapshot(other.snapshot)
+{
+    other.slot = nullptr;
+}
+
+CCLIP_INLINE cclip::config_reloader::reader::~reader()
+{
+    if (this->slot != nullptr)
+    {
+        this->slot->pointer.store(nullptr, std::memory_order_release);
+        this->slot->claimed.store(false, std::memory_order_release);
+    }
+}
+
+CCLIP_INLINE cclip::config_reloader::config_reloader(const options_manager &schema, std::string path) : schema(schema), path(std::move(path)), state(nullptr)
+{
+    auto first = std::make_unique<config_snapshot>(this->schema, this->path);
+    this->state = new shared_state();
+    this->state->current.store(first.release(), std::memory_order_release);
+}
+
+CCLIP_INLINE cclip::config_reloader::~config_reloader()
+{
+    this->stop();
+    for (const config_snapshot *snapshot: this->state->retired)
+    {
+        delete snapshot;
+    }
+    delete this->state->current.load(std::memory_order_acquire);
+    delete this->state;
+}
+
+CCLIP_INLINE void cclip::config_reloader::start()
+{
+    if (this->state->running.exchange(true))
+    {
+        return;
+    }
+    this->state->watcher = std::thread(&config_reloader::watch, this);
+}
+
+CCLIP_INLINE void cclip::config_reloader::stop()
+{
+    this->state->running.store(false);
+    if (this->state->watcher.joinable())
+    {
+        this->state->watcher.join();
+    }
+}
+
+CCLIP_INLINE bool cclip::config_reloader::reload()
+{
+    std::unique_ptr<config_snapshot> next;
+    try
+    {
+        next = std::make_unique<config_snapshot>(this->schema, this->path);
+    } catch (const std::exception &e)
+    {
+        this->report(e);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(this->state->reload_mutex);
+    this->state->retired.push_back(this->state->current.exchange(next.release(), std::memory_order_seq_cst));
+    this->reclaim();
+    return true;
+}
+
+CCLIP_INLINE cclip::config_reloader::reader cclip::config_reloader::read() const
+{
+    // Start at a slot derived from the thread so concurrent readers rarely compete for the same one
+    const size_t start = std::hash<std::thread::id>{}(std::this_thread::get_id()) % max_readers;
+    for (size_t i = start;; i = (i + 1) % max_readers)
+    {
+        hazard_slot &slot = this->state->hazards[i];
+        bool expected = false;
+        if (!slot.claimed.load(std::memory_order_relaxed) && slot.claimed.compare_exchange_strong(expected, true, std::memory_order_acquire))
+        {
+            // Publish the pointer, then make sure it was not swapped out before the publication became visible
+            const config_snapshot *snapshot = this->state->current.load(std::memory_order_seq_cst);
+            for (;;)
+            {
+                slot.pointer.store(snapshot, std::memory_order_seq_cst);
+                const config_snapshot *latest = this->state->current.load(std::memory_order_seq_cst);
+                if (latest == snapshot)
+                {
+                    return reader(&slot, snapshot);
+                }
+                snapshot = latest;
+            }
+        }
+        if ((i + 1) % max_readers == start)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+CCLIP_INLINE void cclip::config_reloader::on_error(callback<void(const std::exception &)> handler)
+{
+    this->state->error_handler = std::move(handler);
+}
+
+CCLIP_INLINE void cclip::config_reloader::reclaim()
+{
+    std::vector<const config_snapshot *> still_read;
+    for (const config_snapshot *snapshot: this->state->retired)
+    {
+        bool in_use = false;
+        for (const hazard_slot &slot: this->state->hazards)
+        {
+            if (slot.pointer.load(std::memory_order_seq_cst) == snapshot)
+            {
+                in_use = true;
+                break;
+            }
+        }
+        if (in_use)
+        {
+            still_read.push_back(snapshot);
+        } else
+        {
+            delete snapshot;
+        }
+    }
+    this->state->retired = std::move(still_read);
+}
+
+CCLIP_INLINE void cclip::config_reloader::report(const std::exception &error) const
+{
+    if (this->state->error_handler)
+    {
+        this->state->error_handler(error);
+        return;
+    }
+    std::cerr << "Failed to reload config file " << this->path << ": " << error.what() << std::endl;
+}
+
+CCLIP_INLINE void cclip::config_reloader::watch()
+{
+    const std::filesystem::path file(this->path);
+#ifdef __linux__
+    // Watch the directory rather than the file, editors often replace the file instead of writing to it
+    const std::string directory = file.has_parent_path() ? file.parent_path().string() : ".";
+    const std::string name = file.filename().string();
+    const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd >= 0 && inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) >= 0)
+    {
+        alignas(inotify_event) char events[4096];
+        while (this->state->running.load())
+        {
+            pollfd descriptor{fd, POLLIN, 0};
+            if (poll(&descriptor, 1, 250) <= 0)
+            {
+                continue;
+            }
+            bool changed = false;
+            ssize_t length;
+            while ((length = ::read(fd, events, sizeof(events))) > 0)
+            {
+                for (const char *ptr = events; ptr < events + length;)
+                {
+                    const auto *event = reinterpret_cast<const inotify_event *>(ptr);
+                    changed |= event->len > 0 && name == event->name;
+                    ptr += sizeof(inotify_event) + event->len;
+                }
+            }
+            if (changed)
+            {
+                this->reload();
+            }
+        }
+        close(fd);
+        return;
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+#endif
+    std::error_code error;
+    auto last_write = std::filesystem::last_write_time(file, error);
+    while (this->state->running.load())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        const auto write = std::filesystem::last_write_time(file, error);
+        if (!error && write != last_write)
+        {
+            last_write = write;
+            this->reload();
+        }
+    }
+}
+
+
+
+#include <fstream>
+#include <string>
+#include <sstream>
+#include <stdexcept>
+
+CCLIP_INLINE cclip::config_snapshot::config_snapshot(const options_manager &schema, const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("Unable to read config file: " + path);
+    }
+    std::stringstream content;
+    content << file.rdbuf();
+
+    // Rewrite every entry as command line tokens ("--name", "value") so the file is validated by the same parser as argv
+    std::vector<size_t> offsets;
+    offsets.push_back(0);
+    this->buffer.append(path).push_back('\0');
+
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(content, line))
+    {
+        ++line_number;
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+        {
+            continue;
+        }
+        const size_t last = line.find_last_not_of(" \t\r");
+        line = line.substr(first, last - first + 1);
+
+        const size_t separator = line.find('=');
+        std::string name = line.substr(0, separator);
+        name.erase(name.find_last_not_of(" \t") + 1);
+        if (name.empty())
+        {
+            // It would become the -- terminator and turn the value into an operand
+            throw parse_error("Missing option name (line " + std::to_string(line_number) + ")");
+        }
+
+        // Without this check a bare name would take the next entry as its argument, and a value given to a flag would become an operand
+        const option *opt = schema.find_option(name);
+        if (opt != nullptr && opt->has_argument && separator == std::string::npos)
+        {
+            throw parse_error("Missing value for option: " + name + " (line " + std::to_string(line_number) + ")");
+        }
+        if (opt != nullptr && !opt->has_argument && separator != std::string::npos)
+        {
+            throw parse_error("Option does not take a value: " + name + " (line " + std::to_string(line_number) + ")");
+        }
+        offsets.push_back(this->buffer.size());
+        this->buffer.append(name.size() == 1 ? "-" : "--").append(name).push_back('\0');
+
+        if (separator != std::string::npos)
+        {
+            std::string value = line.substr(separator + 1);
+            value.erase(0, value.find_first_not_of(" \t"));
+            if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+            {
+                value = value.substr(1, value.size() - 2);
+            }
+            offsets.push_back(this->buffer.size());
+            this->buffer.append(value).push_back('\0');
+        }
+    }
+
+    this->args.reserve(offsets.size());
+    for (const size_t offset: offsets)
+    {
+        this->args.push_back(&this->buffer[offset]);
+    }
+    // Only names and values: required options may still come from the command line, and a config file cannot give positional arguments
+    schema.parse_arguments(static_cast<int>(this->args.size()), this->args.data(), this->result, false, nullptr, false);
+}
+
+CCLIP_INLINE const cclip::parse_result &cclip::config_snapshot::get_result() const
+{
+    return this->result;
+}
+
+
+#include <algorithm>
+#include <bitset>
+
+CCLIP_INLINE void cclip::constraint_set::add(const std::vector<std::uint32_t> &trigger, const std::vector<std::uint32_t> &group, const std::uint32_t min_count, const std::uint32_t max_count, std::string message)
+{
+    std::uint32_t highest = 0;
+    for (const std::uint32_t index: trigger)
+    {
+        highest = std::max(highest, index);
+    }
+    for (const std::uint32_t index: group)
+    {
+        highest = std::max(highest, index);
+    }
+
+    // The trigger mask comes first, then the group mask, each as wide as the highest option index the rule mentions
+    const size_t words = highest / 64 + 1;
+    const size_t offset = this->masks.size();
+    this->masks.resize(offset + words * 2, 0);
+    for (const std::uint32_t index: trigger)
+    {
+        this->masks[offset + index / 64] |= std::uint64_t{1} << (index % 64);
+    }
+    for (const std::uint32_t index: group)
+    {
+        this->masks[offset + words + index / 64] |= std::uint64_t{1} << (index % 64);
+    }
+    this->rules.push_back(rule{offset, words, min_count, max_count, std::move(message)});
+}
+
+CCLIP_INLINE bool cclip::constraint_set::check(const std::vector<std::uint64_t> &presence, std::string &errors) const
+{
+    bool valid = true;
+    for (const rule &current: this->rules)
+    {
+        const std::uint64_t *trigger = this->masks.data() + current.offset;
+        const std::uint64_t *group = trigger + current.words;
+        std::uint64_t untriggered = 0;
+        size_t count = 0;
+        for (size_t w = 0; w < current.words; ++w)
+        {
+            const std::uint64_t present = w < presence.size() ? presence[w] : 0;
+            untriggered |= trigger[w] & ~present;
+            count += std::bitset<64>(present & group[w]).count();
+        }
+        if (untriggered == 0 && (count < current.min_count || count > current.max_count))
+        {
+            if (!errors.empty())
+            {
+                errors += "\n";
+            }
+            errors += current.message;
+            valid = false;
+        }
+    }
+    return valid;
+}
+
+
+#include <mutex>
+#include <utility>
+
+struct cclip::default_value::lazy_state
+{
+    std::once_flag once;
+};
+
+CCLIP_INLINE cclip::default_value::default_value(const char *value, const int choice_value) : value(value), label(value), choice_value(choice_value), state(nullptr)
+{
+}
+
+CCLIP_INLINE cclip::default_value::default_value(callback<std::string()> compute, const char *label) : value(nullptr), compute(std::move(compute)), label(label), choice_value(-1), state(new lazy_state())
+{
+}
+
+CCLIP_INLINE cclip::default_value::~default_value()
+{
+    delete this->state;
+}
+
+CCLIP_INLINE const char *cclip::default_value::get() const
+{
+    if (this->value != nullptr)
+    {
+        return this->value;
+    }
+    std::call_once(this->state->once, [this] { this->computed = this->compute(); });
+    return this->computed.c_str();
+}
+
+CCLIP_INLINE const char *cclip::default_value::get_label() const
+{
+    return this->label;
+}
+
+
+
+CCLIP_INLINE cclip::event_stream::event_stream(const options_manager &schema, const int argc, const char *const *argv) : schema(schema), argc(argc), argv(argv), position(1), terminated(false)
+{
+}
+
+CCLIP_INLINE bool cclip::event_stream::next(parse_event &event)
+{
+    while (this->position < this->argc)
+    {
+        const char *arg = this->argv[this->position++];
+        event = parse_event();
+        const std::int32_t id = this->terminated ? -1 : this->schema.classify(arg);
+        if (id == -1)
+        {
+            event.value = arg;
+            if (this->schema.utf8_validation && !is_valid_utf8(event.value))
+            {
+                event.kind = event_kind::error;
+                event.error = event_error::invalid_utf8;
+            }
+            return true;
+        }
+        if (id == -3)
+        {
+            this->terminated = true; // everything after -- is an operand
+            continue;
+        }
+
+        event.name = arg;
+        if (id == -2)
+        {
+            event.kind = event_kind::error;
+            event.error = event_error::unknown_option;
+            return true;
+        }
+        const option *opt = this->schema.options[id];
+        event.kind = event_kind::option;
+        event.option = option_handle{opt->index};
+        if (!opt->has_argument)
+        {
+            return true;
+        }
+        if (this->position >= this->argc)
+        {
+            event.kind = event_kind::error;
+            event.error = event_error::missing_argument;
+            return true;
+        }
+        const char *argument = this->argv[this->position++];
+        event.value = argument;
+        if (this->schema.utf8_validation && !is_valid_utf8(event.value))
+        {
+            event.kind = event_kind::error;
+            event.error = event_error::invalid_utf8;
+            return true;
+        }
+        if (opt->choices != nullptr)
+        {
+            const choice *match = opt->choices->find(argument);
+            if (match == nullptr)
+            {
+                event.kind = event_kind::error;
+                event.error = event_error::invalid_value;
+                return true;
+            }
+            event.choice_value = match->value;
+        }
+        return true;
+    }
+    return false;
+}
+
+CCLIP_INLINE cclip::event_stream cclip::events(const options_manager &schema, const int argc, const char *const *argv)
+{
+    return event_stream(schema, argc, argv);
+}
+
+
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <string_view>
+
+CCLIP_INLINE cclip::incremental_parser::incremental_parser(const options_manager &schema) : schema(schema), gap_begin(0), gap_end(0), counts(schema.get_options().size(), 0), presence((schema.get_options().size() + 63) / 64, 0), error_count(0), missing_required(0), before_requires_present(0), operand_count(0), min_operands(0), max_operands(std::numeric_limits<size_t>::max())
+{
+    for (const auto &option: this->schema.get_options())
+    {
+        this->missing_required += option->is_required;
+    }
+    const auto &positionals = this->schema.get_positionals();
+    for (size_t i = 0; i < positionals.size(); ++i)
+    {
+        if (positionals[i].is_required)
+        {
+            this->min_operands = i + 1;
+        }
+    }
+    if (!positionals.empty() && !positionals.back().is_variadic)
+    {
+        this->max_operands = positionals.size();
+    }
+}
+
+CCLIP_INLINE void cclip::incremental_parser::set_line(const std::string &line)
+{
+    this->edit(0, this->line.size(), line);
+}
+
+CCLIP_INLINE void cclip::incremental_parser::edit(size_t offset, size_t erase_count, const std::string &insert)
+{
+    offset = std::min(offset, this->line.size());
+    erase_count = std::min(erase_count, this->line.size() - offset);
+    const size_t erase_end = offset + erase_count;
+
+    // The tokens touching the edit are replaced; a token ending at the offset or starting right after the erased text may grow
+    const size_t token_count = this->get_token_count();
+    size_t first = 0;
+    for (size_t high = token_count; first < high;)
+    {
+        const size_t middle = first + (high - first) / 2;
+        if (this->begin_of(middle) + this->stored(middle).length < offset)
+            first = middle + 1;
+        else
+            high = middle;
+    }
+    size_t last = first;
+    for (size_t high = token_count; last < high;)
+    {
+        const size_t middle = last + (high - last) / 2;
+        if (this->begin_of(middle) <= erase_end)
+            last = middle + 1;
+        else
+            high = middle;
+    }
+
+    const size_t region_begin = first < last ? std::min(this->begin_of(first), offset) : offset;
+    const size_t region_end = first < last ? std::max(this->begin_of(last - 1) + this->stored(last - 1).length, erase_end) : erase_end;
+
+    // The token before the edit may change from missing its argument to having one, so it is re-classified as well
+    const size_t recount_begin = first > 0 ? first - 1 : 0;
+    for (size_t i = recount_begin; i < last; ++i)
+    {
+        this->count(this->stored(i), -1);
+    }
+
+    // Open the gap where the replaced tokens were, the tokens behind it are measured from the end of the line and keep their offsets
+    this->move_gap(last);
+    this->gap_begin = first;
+    this->line.replace(offset, erase_count, insert);
+    const std::ptrdiff_t delta = static_cast<std::ptrdiff_t>(insert.size()) - static_cast<std::ptrdiff_t>(erase_count);
+
+    std::vector<token> replacement;
+    this->tokenize(region_begin, region_end + delta, replacement);
+    if (this->gap_end - this->gap_begin < replacement.size())
+    {
+        const size_t extra = std::max(replacement.size(), this->tokens.size());
+        this->tokens.insert(this->tokens.begin() + static_cast<std::ptrdiff_t>(this->gap_end), extra, token{});
+        this->gap_end += extra;
+    }
+    std::copy(replacement.begin(), replacement.end(), this->tokens.begin() + static_cast<std::ptrdiff_t>(this->gap_begin));
+    this->gap_begin += replacement.size();
+
+    // Re-classify until an untouched token keeps the classification it had before
+    const size_t replaced_end = first + replacement.size();
+    const size_t new_count = this->get_token_count();
+    for (size_t i = recount_begin; i < new_count; ++i)
+    {
+        token &t = this->stored(i);
+        std::int32_t option;
+        const token_kind kind = this->classify(i, option);
+        if (i >= replaced_end)
+        {
+            if (kind == t.kind && option == t.option)
+            {
+                break;
+            }
+            this->count(t, -1);
+        }
+        t.kind = kind;
+        t.option = option;
+        this->count(t, 1);
+    }
+}
+
+CCLIP_INLINE cclip::incremental_parser::token &cclip::incremental_parser::stored(const size_t index)
+{
+    return this->tokens[index < this->gap_begin ? index : index + (this->gap_end - this->gap_begin)];
+}
+
+CCLIP_INLINE size_t cclip::incremental_parser::begin_of(const size_t index) const
+{
+    return index < this->gap_begin ? this->tokens[index].begin : this->line.size() - this->tokens[index + (this->gap_end - this->gap_begin)].begin;
+}
+
+CCLIP_INLINE void cclip::incremental_parser::move_gap(const size_t index)
+{
+    // Tokens crossing the gap switch between being measured from the start and from the end of the line
+    const size_t size = this->line.size();
+    while (this->gap_begin > index)
+    {
+        token &t = this->tokens[--this->gap_end] = this->tokens[--this->gap_begin];
+        t.begin = size - t.begin;
+    }
+    while (this->gap_begin < index)
+    {
+        token &t = this->tokens[this->gap_begin++] = this->tokens[this->gap_end++];
+        t.begin = size - t.begin;
+    }
+}
+
+CCLIP_INLINE void cclip::incremental_parser::tokenize(size_t begin, const size_t end, std::vector<token> &out) const
+{
+    while (begin < end)
+    {
+        while (begin < end && std::isspace(static_cast<unsigned char>(this->line[begin])))
+        {
+            ++begin;
+        }
+        size_t token_end = begin;
+        while (token_end < end && !std::isspace(static_cast<unsigned char>(this->line[token_end])))
+        {
+            ++token_end;
+        }
+        if (token_end > begin)
+        {
+            out.push_back(token{begin, token_end - begin, token_kind::operand, -1});
+        }
+        begin = token_end;
+    }
+}
+
+CCLIP_INLINE cclip::incremental_parser::token_kind cclip::incremental_parser::classify(const size_t index, std::int32_t &option) const
+{
+    const token t = this->get_token(index);
+    const std::string_view text(this->line.data() + t.begin, t.length);
+    const auto &options = this->schema.get_options();
+    option = -1;
+    if (index > 0)
+    {
+        const token previous = this->get_token(index - 1);
+        if (previous.kind == token_kind::option && options[previous.option]->has_argument)
+        {
+            option = previous.option;
+            if (this->schema.utf8_validation && !is_valid_utf8(text))
+            {
+                return token_kind::invalid_utf8;
+            }
+            const choice_table *choices = options[option]->choices;
+            return choices != nullptr && choices->find(text) == nullptr ? token_kind::invalid_value : token_kind::argument;
+        }
+        if (previous.kind == token_kind::terminator || previous.kind == token_kind::literal || previous.kind == token_kind::invalid_utf8_literal)
+        {
+            return this->schema.utf8_validation && !is_valid_utf8(text) ? token_kind::invalid_utf8_literal : token_kind::literal;
+        }
+    }
+    if (text[0] != '-' || t.length == 1)
+    {
+        return this->schema.utf8_validation && !is_valid_utf8(text) ? token_kind::invalid_utf8 : token_kind::operand;
+    }
+    if (t.length == 2 && text[1] == '-')
+    {
+        return token_kind::terminator;
+    }
+    const bool is_long = t.length > 1 && text[1] == '-';
+    const cclip::option *opt = this->schema.find_option(text.substr(is_long ? 2 : 1));
+    if (opt == nullptr)
+    {
+        return token_kind::unknown_option;
+    }
+    option = static_cast<std::int32_t>(opt->index);
+    return opt->has_argument && index + 1 == this->get_token_count() ? token_kind::missing_argument : token_kind::option;
+}
+
+CCLIP_INLINE void cclip::incremental_parser::count(const token &t, const int direction)
+{
+    switch (t.kind)
+    {
+        case token_kind::option:
+        {
+            const option *opt = this->schema.get_options()[t.option];
+            std::uint32_t &occurrences = this->counts[t.option];
+            const bool was_present = occurrences > 0;
+            occurrences += direction;
+            if (was_present != (occurrences > 0))
+            {
+                const int change = occurrences > 0 ? 1 : -1;
+                this->missing_required -= opt->is_required ? change : 0;
+                this->before_requires_present += opt->executes_before_requires ? change : 0;
+                this->presence[t.option / 64] ^= std::uint64_t{1} << t.option % 64;
+            }
+            break;
+        }
+        case token_kind::operand:
+        case token_kind::literal:
+            this->operand_count += direction;
+            break;
+        case token_kind::unknown_option:
+        case token_kind::missing_argument:
+        case token_kind::invalid_value:
+        case token_kind::invalid_utf8:
+        case token_kind::invalid_utf8_literal:
+            this->error_count += direction;
+            break;
+        default:
+            break;
+    }
+}
+
+CCLIP_INLINE const std::string &cclip::incremental_parser::get_line() const
+{
+    return this->line;
+}
+
+CCLIP_INLINE size_t cclip::incremental_parser::get_token_count() const
+{
+    return this->tokens.size() - (this->gap_end - this->gap_begin);
+}
+
+CCLIP_INLINE cclip::incremental_parser::token cclip::incremental_parser::get_token(const size_t index) const
+{
+    if (index < this->gap_begin)
+    {
+        return this->tokens[index];
+    }
+    token t = this->tokens[index + (this->gap_end - this->gap_begin)];
+    t.begin = this->line.size() - t.begin;
+    return t;
+}
+
+CCLIP_INLINE std::vector<cclip::incremental_parser::token> cclip::incremental_parser::get_tokens() const
+{
+    std::vector<token> result;
+    result.reserve(this->get_token_count());
+    for (size_t i = 0; i < this->get_token_count(); ++i)
+    {
+        result.push_back(this->get_token(i));
+    }
+    return result;
+}
+
+CCLIP_INLINE std::string cclip::incremental_parser::describe(const token &t) const
+{
+    const std::string text = this->line.substr(t.begin, t.length);
+    switch (t.kind)
+    {
+        case token_kind::unknown_option:
+            return "Unknown option: " + text;
+        case token_kind::missing_argument:
+            return "Missing argument for option: " + text.substr(text.find_first_not_of('-'));
+        case token_kind::invalid_value:
+        {
+            const option *opt = this->schema.get_options()[t.option];
+            return "Invalid value for option: " + std::string(opt->long_name[0] ? opt->long_name : opt->short_name) + " (" + text + ")";
+        }
+        case token_kind::invalid_utf8:
+        case token_kind::invalid_utf8_literal:
+        {
+            if (t.option != -1)
+            {
+                const option *opt = this->schema.get_options()[t.option];
+                return "Invalid UTF-8 in the argument of option: " + std::string(opt->long_name[0] ? opt->long_name : opt->short_name);
+            }
+            // parse numbers the argument by its position in argv, which is one past the token's
+            size_t index = 0;
+            for (size_t high = this->get_token_count(); index < high;)
+            {
+                const size_t middle = index + (high - index) / 2;
+                if (this->begin_of(middle) < t.begin)
+                    index = middle + 1;
+                else
+                    high = middle;
+            }
+            return "Invalid UTF-8 in argument " + std::to_string(index + 1);
+        }
+        default:
+            return "";
+    }
+}
+
+CCLIP_INLINE size_t cclip::incremental_parser::get_error_count() const
+{
+    return this->error_count;
+}
+
+CCLIP_INLINE bool cclip::incremental_parser::is_present(const option_handle handle) const
+{
+    return handle.index < this->counts.size() && this->counts[handle.index] > 0;
+}
+
+CCLIP_INLINE bool cclip::incremental_parser::is_valid() const
+{
+    if (this->error_count != 0)
+    {
+        return false;
+    }
+    if (this->before_requires_present > 0)
+    {
+        return true;
+    }
+    if (this->missing_required != 0 || this->operand_count < this->min_operands || this->operand_count > this->max_operands)
+    {
+        return false;
+    }
+    std::string errors;
+    return this->schema.constraints.check(this->presence, errors);
+}
+
+
+CCLIP_INLINE std::uint32_t cclip::name_table::hash(const std::string_view name)
+{
+    // FNV-1a
+    std::uint32_t hash = 2166136261u;
+    for (const char c: name)
+    {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+CCLIP_INLINE void cclip::name_table::grow()
+{
+    std::vector<slot> previous(this->slots.empty() ? 16 : this->slots.size() * 2);
+    previous.swap(this->slots);
+    const size_t mask = this->slots.size() - 1;
+    for (const slot &entry: previous)
+    {
+        if (entry.name.empty())
+        {
+            continue;
+        }
+        size_t position = hash(entry.name) & mask;
+        while (!this->slots[position].name.empty())
+        {
+            position = (position + 1) & mask;
+        }
+        this->slots[position] = entry;
+    }
+}
+
+CCLIP_INLINE bool cclip::name_table::insert(const std::string_view name, const std::uint32_t index)
+{
+    // Keep the table at most half full so probe sequences stay short
+    if ((this->count + 1) * 2 > this->slots.size())
+    {
+        this->grow();
+    }
+    const size_t mask = this->slots.size() - 1;
+    size_t position = hash(name) & mask;
+    while (!this->slots[position].name.empty())
+    {
+        if (this->slots[position].name == name)
+        {
+            return false;
+        }
+        position = (position + 1) & mask;
+    }
+    this->slots[position] = slot{name, index};
+    ++this->count;
+    return true;
+}
+
+CCLIP_INLINE std::int32_t cclip::name_table::find(const std::string_view name) const
+{
+    if (this->slots.empty() || name.empty())
+    {
+        return -1;
+    }
+    const size_t mask = this->slots.size() - 1;
+    for (size_t position = hash(name) & mask; !this->slots[position].name.empty(); position = (position + 1) & mask)
+    {
+        if (this->slots[position].name == name)
+        {
+            return static_cast<std::int32_t>(this->slots[position].index);
+        }
+    }
+    return -1;
+}
+
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+CCLIP_INLINE cclip::options_manager::options_manager(const char *context, const char *description)
+{
+    this->context = context;
+    this->description = description;
+    this->version = nullptr;
+    this->parallel_threshold = 65536;
+    this->utf8_validation = false;
+    this->help_width = 0;
+    this->label_column = 0;
+}
+
+CCLIP_INLINE cclip::options_manager::~options_manager()
+{
+    for (const option *opt: this->options)
+    {
+        delete opt->choices;
+        delete opt->defaults;
+        delete opt;
+    }
+}
+
+CCLIP_INLINE void cclip::options_manager::add_example_usage(const char *example_usage)
+{
+    this->example_usages.push_back(example_usage);
+}
+
+CCLIP_INLINE void cclip::options_manager::set_version(const char *version)
+{
+    this->version = version;
+}
+
+CCLIP_INLINE const char *cclip::options_manager::get_version()
+{
+    return this->version;
+}
+
+CCLIP_INLINE void cclip::options_manager::print_version() const
+{
+    if (this->version != nullptr)
+    {
+        std::cout <<
+#ifdef ANSIConsoleColors
+                    colors::ConsoleColors::GetColorCode(colors::ColorCodes::Green) <<
+#endif
+                this->context << " " <<
+#ifdef ANSIConsoleColors
+                    colors::ConsoleColors::GetColorCode(colors::ColorCodes::Yellow) <<
+#endif
+                this->version <<
+#ifdef ANSIConsoleColors
+                    colors::ConsoleColors::GetColorCode(colors::ColorCodes::Default) <<
+#endif
+                std::endl;
+    }
+}
+
+CCLIP_INLINE void cclip::options_manager::print_examples() const
+{
+    std::cout <<
+#ifdef ANSIConsoleColors
+                colors::ConsoleColors::GetColorCode(colors::ColorCodes::Yellow) <<
+#endif
+            "Example Usages:" <<
+#ifdef ANSIConsoleColors
+                colors::ConsoleColors::GetColorCode(colors::ColorCodes::Blue) <<
+#endif
+            std::endl;
+    for (const auto &example_usage: this->example_usages)
+    {
+        std::cout <<
+                example_usage <<
+                std::endl;
+    }
+
+#ifdef ANSIConsoleColors
+        colors::ConsoleColors::ResetConsoleColor();
+#endif
+}
+
+CCLIP_INLINE cclip::option_handle cclip::options_manager::add_option(const char *short_name, const char *long_name, const char *description, const bool is_required, const bool has_argument, const bool executes_before_requires)
+{
+    auto *opt = new option{short_name, long_name, description, is_required, has_argument, executes_before_requires, nullptr};
+    opt->index = static_cast<std::uint32_t>(this->options.size());
+    this->options.push_back(opt);
+    this->handlers.emplace_back();
+    if (short_name[0])
+    {
+        this->names.insert(short_name, opt->index);
+        this->suggestions.add(short_name, opt->index, false);
+    }
+    if (long_name[0])
+    {
+        this->names.insert(long_name, opt->index);
+        this->suggestions.add(long_name, opt->index, true);
+    }
+    this->measure_option(opt->index);
+    return option_handle{opt->index};
+}
+
+CCLIP_INLINE cclip::option_handle cclip::options_manager::add_choice_option(const char *short_name, const char *long_name, const char *description, const bool is_required, const std::initializer_list<choice> choices)
+{
+    return this->add_choice_option(short_name, long_name, description, is_required, std::vector<choice>(choices));
+}
+
+CCLIP_INLINE cclip::option_handle cclip::options_manager::add_choice_option(const char *short_name, const char *long_name, const char *description, const bool is_required, std::vector<choice> choices)
+{
+    const option_handle handle = this->add_option(short_name, long_name, description, is_required, true);
+    this->options[handle.index]->choices = new choice_table(std::move(choices));
+    this->measure_option(handle.index);
+    return handle;
+}
+
+CCLIP_INLINE cclip::option_handle cclip::options_manager::add_choice_option(const char *short_name, const char *long_name, const char *description, const bool is_required, const std::initializer_list<const char *> choices)
+{
+    std::vector<choice> indexed;
+    for (const char *value: choices)
+    {
+        indexed.emplace_back(value, indexed.size());
+    }
+    return this->add_choice_option(short_name, long_name, description, is_required, std::move(indexed));
+}
+
+CCLIP_INLINE cclip::positional_handle cclip::options_manager::add_positional(const char *name, const char *description, const bool is_required)
+{
+    if (!this->positionals.empty() && this->positionals.back().is_variadic)
+    {
+        throw std::logic_error("Positional arguments must be added before the variadic argument.");
+    }
+    this->positionals.push_back(positional{name, description, is_required, false});
+    this->measure_positionals();
+    return positional_handle{static_cast<std::uint32_t>(this->positionals.size() - 1)};
+}
+
+CCLIP_INLINE void cclip::options_manager::set_variadic(const char *name, const char *description, const bool is_required)
+{
+    if (!this->positionals.empty() && this->positionals.back().is_variadic)
+    {
+        this->positionals.pop_back();
+    }
+    this->positionals.push_back(positional{name, description, is_required, true});
+    this->measure_positionals();
+}
+
+CCLIP_INLINE const char *cclip::options_manager::get(const positional_handle handle) const
+{
+    const operand_span operands = this->result.get_operands();
+    return handle.index < operands.size() ? operands[handle.index] : nullptr;
+}
+
+CCLIP_INLINE cclip::operand_span cclip::options_manager::get_operands() const
+{
+    return this->result.get_operands();
+}
+
+CCLIP_INLINE cclip::operand_span cclip::options_manager::get_variadic() const
+{
+    const size_t named = this->positionals.empty() || !this->positionals.back().is_variadic ? this->positionals.size() : this->positionals.size() - 1;
+    return this->result.get_operands().subspan(named);
+}
+
+CCLIP_INLINE const std::vector<cclip::positional> &cclip::options_manager::get_positionals() const
+{
+    return this->positionals;
+}
+
+CCLIP_INLINE void cclip::options_manager::set_default(const option_handle handle, const char *value)
+{
+    if (handle.index >= this->options.size())
+    {
+        throw std::invalid_argument("Default value refers to an option that does not exist.");
+    }
+    if (value == nullptr)
+    {
+        throw std::invalid_argument("Default value must not be null.");
+    }
+    option *opt = this->options[handle.index];
+    if (!opt->has_argument)
+    {
+        throw std::logic_error("Only options with an argument can have a default value.");
+    }
+    int choice_value = -1;
+    if (opt->choices != nullptr)
+    {
+        const choice *match = opt->choices->find(value);
+        if (match == nullptr)
+        {
+            throw std::invalid_argument("Default value is not one of the choices: " + std::string(value));
+        }
+        choice_value = match->value;
+    }
+    delete opt->defaults;
+    opt->defaults = new default_value(value, choice_value);
+}
+
+CCLIP_INLINE void cclip::options_manager::set_default(const option_handle handle, callback<std::string()> compute, const char *label)
+{
+    if (handle.index >= this->options.size())
+    {
+        throw std::invalid_argument("Default value refers to an option that does not exist.");
+    }
+    if (!compute)
+    {
+        throw std::invalid_argument("Computed default value must not be empty.");
+    }
+    option *opt = this->options[handle.index];
+    if (!opt->has_argument)
+    {
+        throw std::logic_error("Only options with an argument can have a default value.");
+    }
+    if (opt->choices != nullptr)
+    {
+        throw std::logic_error("Choice options need a fixed default value, one of their choices.");
+    }
+    delete opt->defaults;
+    opt->defaults = new default_value(std::move(compute), label);
+}
+
+CCLIP_INLINE const char *cclip::options_manager::get_or_default(const option_handle handle) const
+{
+    return this->get_or_default(this->result, handle);
+}
+
+CCLIP_INLINE const char *cclip::options_manager::get_or_default(const parse_result &result, const option_handle handle) const
+{
+    const char *argument = result.get(handle);
+    if (argument != nullptr || handle.index >= this->options.size() || this->options[handle.index]->defaults == nullptr)
+    {
+        return argument;
+    }
+    return this->options[handle.index]->defaults->get();
+}
+
+CCLIP_INLINE std::string cclip::options_manager::display_names(const std::initializer_list<option_handle> handles) const
+{
+    std::string names;
+    for (const option_handle handle: handles)
+    {
+        if (handle.index >= this->options.size())
+        {
+            throw std::invalid_argument("Constraint refers to an option that does not exist.");
+        }
+        const option *opt = this->options[handle.index];
+        if (!names.empty())
+        {
+            names += ", ";
+        }
+        names += opt->long_name[0] ? "--" + std::string(opt->long_name) : "-" + std::string(opt->short_name);
+    }
+    return names;
+}
+
+CCLIP_INLINE void cclip::options_manager::add_requires(const option_handle handle, const std::initializer_list<option_handle> required)
+{
+    const std::string message = "Option " + this->display_names({handle}) + " requires " + this->display_names(required);
+    std::vector<std::uint32_t> group;
+    for (const option_handle other: required)
+    {
+        group.push_back(other.index);
+    }
+    const auto count = static_cast<std::uint32_t>(group.size());
+    this->constraints.add({handle.index}, group, count, count, message);
+}
+
+CCLIP_INLINE void cclip::options_manager::add_conflicts(const option_handle handle, const std::initializer_list<option_handle> conflicting)
+{
+    const std::string message = "Option " + this->display_names({handle}) + " conflicts with " + this->display_names(conflicting);
+    std::vector<std::uint32_t> group;
+    for (const option_handle other: conflicting)
+    {
+        group.push_back(other.index);
+    }
+    this->constraints.add({handle.index}, group, 0, 0, message);
+}
+
+CCLIP_INLINE void cclip::options_manager::add_one_of(const std::initializer_list<option_handle> group)
+{
+    const std::string message = "Exactly one of these options must be given: " + this->display_names(group);
+    std::vector<std::uint32_t> indices;
+    for (const option_handle handle: group)
+    {
+        indices.push_back(handle.index);
+    }
+    this->constraints.add({}, indices, 1, 1, message);
+}
+
+CCLIP_INLINE void cclip::options_manager::add_any_of(const std::initializer_list<option_handle> group)
+{
+    const std::string message = "At least one of these options must be given: " + this->display_names(group);
+    std::vector<std::uint32_t> indices;
+    for (const option_handle handle: group)
+    {
+        indices.push_back(handle.index);
+    }
+    this->constraints.add({}, indices, 1, static_cast<std::uint32_t>(indices.size()), message);
+}
+
+CCLIP_INLINE void cclip::options_manager::add_at_most_one_of(const std::initializer_list<option_handle> group)
+{
+    const std::string message = "At most one of these options can be given: " + this->display_names(group);
+    std::vector<std::uint32_t> indices;
+    for (const option_handle handle: group)
+    {
+        indices.push_back(handle.index);
+    }
+    this->constraints.add({}, indices, 0, 1, message);
+}
+
+CCLIP_INLINE void cclip::options_manager::on(const option_handle handle, callback<void(const char *argument)> handler)
+{
+    if (handle.index >= this->handlers.size())
+    {
+        throw std::invalid_argument("Handler refers to an option that does not exist.");
+    }
+    this->handlers[handle.index] = std::move(handler);
+}
+
+CCLIP_INLINE void cclip::options_manager::store_argument(const option *opt, const char *name, char *argument, parse_result &result) const
+{
+    if (this->utf8_validation && !is_valid_utf8(argument))
+    {
+        throw parse_error("Invalid UTF-8 in the argument of option: " + std::string(name));
+    }
+    int choice_value = -1;
+    if (opt->choices != nullptr)
+    {
+        const choice *match = opt->choices->find(argument);
+        if (match == nullptr)
+        {
+            std::string message = "Invalid value for option: " + std::string(name) + " (expected one of:";
+            for (const auto &value: opt->choices->get_choices())
+            {
+                message += " ";
+                message += value.name;
+            }
+            throw parse_error(message + ")");
+        }
+        choice_value = match->value;
+    }
+    result.set(opt->index, argument, choice_value);
+}
+
+CCLIP_INLINE void cclip::options_manager::parse_into(const int argc, char **argv, parse_result &result) const
+{
+    this->parse_arguments(argc, argv, result, false, nullptr, true);
+}
+
+CCLIP_INLINE void cclip::options_manager::parse_into(const int argc, char **argv, parse_result &result, option_sink &sink) const
+{
+    this->parse_arguments(argc, argv, result, false, &sink, true);
+}
+
+CCLIP_INLINE bool cclip::options_manager::parse_arguments(const int argc, char **argv, parse_result &result, const bool dispatch, option_sink *sink, const bool complete) const
+{
+    result.reset(this->options.size());
+
+    // Very long argument lists are classified on several threads first, the loop below only resolves arguments and order
+    std::vector<std::int32_t> classes;
+    if (static_cast<size_t>(argc) > this->parallel_threshold)
+    {
+        classes = this->classify_parallel(argc, argv);
+    }
+
+    // Operands are moved to the front of argv as they are found. The options, option arguments and -- they pass are set aside, and when
+    // the parse ends, even on an error, they are written back and rotated in front of the operands. argv then keeps every entry in the
+    // order getopt leaves it: the program name, the options in the order they were given, then the operands, so it parses the same again
+    std::vector<char *> &displaced = result.displaced;
+    displaced.clear();
+    int operand_end = 1;
+    struct argv_guard
+    {
+        char **argv;
+        const int &operand_end;
+        std::vector<char *> &displaced;
+        bool restored;
+
+        // Returns where the operands start once argv is restored
+        char **restore()
+        {
+            char **operands = this->argv + 1 + this->displaced.size();
+            if (!this->restored)
+            {
+                char **options = std::copy(this->displaced.begin(), this->displaced.end(), this->argv + this->operand_end);
+                std::rotate(this->argv + 1, this->argv + this->operand_end, options);
+                this->displaced.clear();
+                this->restored = true;
+            }
+            return operands;
+        }
+
+        ~argv_guard()
+        {
+            this->restore();
+        }
+    } guard{argv, operand_end, displaced, false};
+    bool terminated = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        char *arg = argv[i];
+        const std::int32_t id = terminated ? -1 : classes.empty() ? this->classify(arg) : classes[i];
+        if (id == -1)
+        {
+            if (this->utf8_validation && !is_valid_utf8(arg))
+            {
+                throw parse_error("Invalid UTF-8 in argument " + std::to_string(i));
+            }
+            argv[operand_end++] = arg;
+            continue;
+        }
+        displaced.push_back(arg);
+        if (id == -3)
+        {
+            terminated = true; // everything after -- is an operand
+            continue;
+        }
+
+        // long options are prefixed with two dashes, short options with one
+        const bool is_long = arg[1] == '-';
+        const char *name = arg + (is_long ? 2 : 1);
+        if (id == -2)
+        {
+            std::string message = std::string("Unknown option: ") + (is_long ? "--" : "-") + name;
+            std::vector<std::string> names;
+            for (const suggestion &match: this->suggestions.find(name))
+            {
+                names.push_back((match.is_long ? "--" : "-") + std::string(match.name));
+            }
+            for (size_t n = 0; n < names.size(); ++n)
+            {
+                message += n == 0 ? (names.size() == 1 ? "\nDid you mean " : "\nDid you mean one of: ") : ", ";
+                message += names[n];
+            }
+            if (!names.empty())
+            {
+                message += "?";
+            }
+            throw unknown_option_error(message, std::move(names));
+        }
+        const option *opt = this->options[id];
+        if (opt->has_argument)
+        {
+            if (i + 1 >= argc)
+            {
+                throw parse_error("Missing argument for option: " + std::string(name));
+            }
+            char *argument = argv[++i];
+            displaced.push_back(argument);
+            this->store_argument(opt, name, argument, result);
+        }
+        result.set(opt->index);
+        if (sink != nullptr)
+        {
+            sink->accept(option_handle{opt->index}, result.get({opt->index}), result.get_choice_value({opt->index}));
+        }
+        if (dispatch && this->handlers[opt->index])
+        {
+            this->handlers[opt->index](result.get({opt->index}));
+            if (opt->executes_before_requires)
+            {
+                result.set_operands(operand_span(guard.restore(), static_cast<size_t>(operand_end - 1)));
+                return false;
+            }
+        }
+    }
+    const operand_span operands(guard.restore(), static_cast<size_t>(operand_end - 1));
+    result.set_operands(operands);
+    if (!complete)
+    {
+        return true;
+    }
+
+    for (const auto &option: this->options)
+    {
+        if (option->executes_before_requires && result.is_present({option->index}))
+        {
+            return true;
+        }
+    }
+    std::string missing;
+    for (const auto &option: this->options)
+    {
+        if (option->is_required && !result.is_present({option->index}))
+        {
+            if (!missing.empty())
+            {
+                missing += "\n";
+            }
+            missing += "Missing required option: -" + std::string(option->short_name) + " or --" + option->long_name;
+        }
+    }
+    for (size_t i = 0; i < this->positionals.size(); ++i)
+    {
+        const positional &slot = this->positionals[i];
+        if (slot.is_required && operands.size() <= i)
+        {
+            if (!missing.empty())
+            {
+                missing += "\n";
+            }
+            missing += "Missing required argument: " + std::string(slot.name);
+        }
+    }
+    this->constraints.check(result.get_presence(), missing);
+    if (!missing.empty())
+    {
+        throw parse_error(missing);
+    }
+    if (!this->positionals.empty() && !this->positionals.back().is_variadic && operands.size() > this->positionals.size())
+    {
+        throw parse_error("Unexpected argument: " + std::string(operands[this->positionals.size()]));
+    }
+    return true;
+}
+
+CCLIP_INLINE bool cclip::options_manager::parse(const int argc, char **argv)
+{
+    this->command_name = std::filesystem::path(argv[0]).stem().string(); // Get the executable name
+    bool finished = true;
+    try
+    {
+        finished = this->parse_arguments(argc, argv, this->result, true, nullptr, true);
+    } catch (const parse_error &e)
+    {
+#ifdef ANSIConsoleColors
+        colors::ConsoleColors::SetForegroundColor(colors::ColorCodes::Red);
+#endif
+        std::cerr << e.what() << std::endl;
+#ifdef ANSIConsoleColors
+        colors::ConsoleColors::ResetConsoleColor();
+#endif
+        // A suggestion is more useful than the full help, which can be very long
+        const auto *unknown = dynamic_cast<const unknown_option_error *>(&e);
+        if (unknown == nullptr || unknown->get_suggestions().empty())
+        {
+            this->print_help();
+        }
+        exit(1);
+    }
+    for (const auto &option: this->options)
+    {
+        option->argument = this->result.get({option->index});
+        option->choice_value = this->result.get_choice_value({option->index});
+    }
+    return finished;
+}
+
+CCLIP_INLINE void cclip::options_manager::print_help(const bool print_examples) const
+{
+    const char *help = this->get_help();
+    if (print_examples)
+    {
+        this->print_examples();
+    }
+    std::cout << help << std::endl;
+    delete(help); // Deletes the memory allocated by get_help()
+}
+
+
+CCLIP_INLINE std::string cclip::options_manager::help_label(const option &opt)
+{
+    std::string label;
+    if (opt.short_name[0])
+    {
+        label += "-";
+        label += opt.short_name;
+        if (opt.long_name[0])
+        {
+            label += ", ";
+        }
+    }
+    if (opt.long_name[0])
+    {
+        label += "--";
+        label += opt.long_name;
+    }
+    if (opt.choices != nullptr)
+    {
+        label += " <";
+        const auto &values = opt.choices->get_choices();
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            label += i ? "|" : "";
+            label += values[i].name;
+        }
+        label += ">";
+    } else if (opt.has_argument)
+    {
+        label += " <arg>";
+    }
+    return label;
+}
+
+CCLIP_INLINE std::string cclip::options_manager::help_label(const positional &slot)
+{
+    return "<" + std::string(slot.name) + ">" + (slot.is_variadic ? "..." : "");
+}
+
+CCLIP_INLINE void cclip::options_manager::measure_option(const std::uint32_t index)
+{
+    if (this->option_label_widths.size() <= index)
+    {
+        this->option_label_widths.resize(index + 1, 0);
+    }
+    this->option_label_widths[index] = display_width(help_label(*this->options[index]));
+    this->label_column = std::max(this->label_column, this->option_label_widths[index]);
+}
+
+CCLIP_INLINE void cclip::options_manager::measure_positionals()
+{
+    // The variadic argument can be replaced, so the column is measured again from every label
+    this->positional_label_widths.clear();
+    this->label_column = 0;
+    for (const positional &slot: this->positionals)
+    {
+        this->positional_label_widths.push_back(display_width(help_label(slot)));
+        this->label_column = std::max(this->label_column, this->positional_label_widths.back());
+    }
+    for (const size_t label_width: this->option_label_widths)
+    {
+        this->label_column = std::max(this->label_column, label_width);
+    }
+}
+
+CCLIP_INLINE void cclip::options_manager::align_help_column(std::ostream &out, size_t &cursor, const size_t column, const size_t indent)
+{
+    // Labels wider than the column get their description on the next line
+    if (cursor > column)
+    {
+        out << "\n";
+        cursor = 0;
+    }
+    out << std::string(indent - cursor, ' ');
+    cursor = indent;
+}
+
+CCLIP_INLINE void cclip::options_manager::append_wrapped(std::ostream &out, const std::string_view text, size_t &cursor, const size_t indent, const size_t width)
+{
+    size_t start = 0;
+    while (start < text.size())
+    {
+        size_t end = text.find_first_of(" \n", start);
+        if (end == std::string_view::npos)
+        {
+            end = text.size();
+        }
+        const std::string_view word = text.substr(start, end - start);
+        if (!word.empty())
+        {
+            const size_t word_width = display_width(word);
+            if (cursor > indent && cursor + 1 + word_width > width)
+            {
+                out << "\n" << std::string(indent, ' ');
+                cursor = indent;
+            } else if (cursor > indent)
+            {
+                out << ' ';
+                ++cursor;
+            }
+            out << word;
+            cursor += word_width;
+        }
+        if (end < text.size() && text[end] == '\n')
+        {
+            out << "\n" << std::string(indent, ' ');
+            cursor = indent;
+        }
+        start = end + 1;
+    }
+}
+
+CCLIP_INLINE size_t cclip::options_manager::terminal_width()
+{
+    if (const char *columns = std::getenv("COLUMNS"); columns != nullptr)
+    {
+        const unsigned long value = std::strtoul(columns, nullptr, 10);
+        if (value > 0)
+        {
+            return value;
+        }
+    }
+#if defined(__unix__) || defined(__APPLE__)
+    winsize size{};
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0)
+    {
+        return size.ws_col;
+    }
+#endif
+    return 80;
+}
+
+CCLIP_INLINE void cclip::options_manager::set_help_width(const size_t columns)
+{
+    this->help_width = columns;
+}
+
+CCLIP_INLINE void cclip::options_manager::set_utf8_validation(const bool enabled)
+{
+    this->utf8_validation = enabled;
+}
+
+CCLIP_INLINE const char *cclip::options_manager::get_help() const
+{
+    std::stringstream buf;
+    buf <<
+#ifdef ANSIConsoleColors
+                colors::ConsoleColors::GetColorCode(colors::ColorCodes::Magenta) <<
+#endif
+            this->context << " Help:\n";
+    if (this->description != nullptr)
+    {
+        buf <<
+#ifdef ANSIConsoleColors
+                colors::ConsoleColors::GetColorCode(colors::ColorCodes::LightGray) <<
+#endif
+                this->description << "\n";
+    }
+
+    // The label column was measured as the options were added, only the descriptions are wrapped to the terminal here
+    const size_t width = this->help_width != 0 ? this->help_width : terminal_width();
+    const size_t column = std::min(this->label_column, width / 2);
+    const size_t indent = column + 2;
+    const size_t text_width = std::max(width, indent + 20);
+
+    for (auto &option: this->options)
+    {
+        if (option->short_name[0])
+        {
+            buf <<
+#ifdef ANSIConsoleColors
+                    colors::ConsoleColors::GetColorCode(colors::ColorCodes::Blue) <<
+#endif
+                    "-" << option->short_name;
+            if (option->long_name[0])
+                buf << ", ";
+        }
+
+        if (option->long_name[0])
+        {
+            buf <<
+#ifdef ANSIConsoleColors
+                    colors::ConsoleColors::GetColorCode(colors::ColorCodes::Cyan) <<
+#endif
+                    "--" << option->long_name;
+        }
+
+        if (option->choices != nullptr)
+        {
+            buf << " <";
+            const auto &values = option->choices->get_choices();
+            for (size_t i = 0; i < values.size(); ++i)
+            {
+                buf << (i ? "|" : "") << values[i].name;
+            }
+            buf << ">";
+        } else if (option->has_argument)
+        {
+            buf << " <arg>";
+        }
+
+        size_t cursor = this->option_label_widths[option->index];
+        align_help_column(buf, cursor, column, indent);
+#ifdef ANSIConsoleColors
+        buf << colors::ConsoleColors::GetColorCode(colors::ColorCodes::LightGray);
+#endif
+        append_wrapped(buf, option->description == nullptr ? "" : option->description, cursor, indent, text_width);
+        if (option->is_required)
+        {
+#ifdef ANSIConsoleColors
+            buf << colors::ConsoleColors::GetColorCode(colors::ColorCodes::Red);
+#endif
+            append_wrapped(buf, "(required)", cursor, indent, text_width);
+        }
+        if (option->defaults != nullptr && option->defaults->get_label() != nullptr)
+        {
+#ifdef ANSIConsoleColors
+            buf << colors::ConsoleColors::GetColorCode(colors::ColorCodes::LightGray);
+#endif
+            append_wrapped(buf, "(default: " + std::string(option->defaults->get_label()) + ")", cursor, indent, text_width);
+        }
+        buf << "\n";
+    }
+
+    for (size_t i = 0; i < this->positionals.size(); ++i)
+    {
+        const positional &slot = this->positionals[i];
+        buf <<
+#ifdef ANSIConsoleColors
+                colors::ConsoleColors::GetColorCode(colors::ColorCodes::Cyan) <<
+#endif
+                "<" << slot.name << ">" << (slot.is_variadic ? "..." : "");
+
+        size_t cursor = this->positional_label_widths[i];
+        align_help_column(buf, cursor, column, indent);
+#ifdef ANSIConsoleColors
+        buf << colors::ConsoleColors::GetColorCode(colors::ColorCodes::LightGray);
+#endif
+        append_wrapped(buf, slot.description == nullptr ? "" : slot.description, cursor, indent, text_width);
+        if (slot.is_required)
+        {
+#ifdef ANSIConsoleColors
+            buf << colors::ConsoleColors::GetColorCode(colors::ColorCodes::Red);
+#endif
+            append_wrapped(buf, "(required)", cursor, indent, text_width);
+        }
+        buf << "\n";
+    }
+
+#ifdef ANSIConsoleColors
+        buf << colors::ConsoleColors::GetColorCode(colors::ColorCodes::Default);
+#endif
+
+    const size_t length = buf.str().length() + 1;
+    const auto help_str = new char[length];
+    strcpy(help_str, buf.str().c_str());
+    return help_str;
+}
+
+CCLIP_INLINE bool cclip::options_manager::is_present(const std::string &name) const
+{
+    const option *opt = this->get_option_from_global_list(name);
+    return opt != nullptr && this->result.is_present({opt->index});
+}
+
+CCLIP_INLINE cclip::option *cclip::options_manager::get_option(const std::string &name)
+{
+    option *opt = this->get_option_from_global_list(name);
+    return opt != nullptr && this->result.is_present({opt->index}) ? opt : nullptr;
+}
+
+CCLIP_INLINE cclip::option *cclip::options_manager::get_option_from_global_list(const std::string &name) const
+{
+    const std::int32_t index = this->names.find(name);
+    return index < 0 ? nullptr : this->options[index];
+}
+
+CCLIP_INLINE std::int32_t cclip::options_manager::classify(const char *arg) const
+{
+    // -1 for an operand, -2 for an unknown option, -3 for the -- terminator, otherwise the index of the option
+    if (arg[0] != '-' || arg[1] == '\0') // a lone dash is an operand, usually meaning stdin
+    {
+        return -1;
+    }
+    if (arg[1] == '-' && arg[2] == '\0')
+    {
+        return -3;
+    }
+    const std::int32_t index = this->names.find(std::string_view(arg + (arg[1] == '-' ? 2 : 1)));
+    return index < 0 ? -2 : index;
+}
+
+CCLIP_INLINE std::vector<std::int32_t> cclip::options_manager::classify_parallel(const int argc, char **argv) const
+{
+    const size_t count = argc;
+    const size_t thread_count = std::min<size_t>(std::thread::hardware_concurrency(), count / 4096);
+    if (thread_count < 2)
+    {
+        return {}; // not worth it, classify while resolving instead
+    }
+    std::vector<std::int32_t> classes(argc, -1);
+    const size_t chunk = (count + thread_count - 1) / thread_count;
+
+    std::vector<std::thread> threads;
+    for (size_t begin = 1; begin < count; begin += chunk)
+    {
+        const size_t end = std::min(count, begin + chunk);
+        threads.emplace_back([this, argv, &classes, begin, end]
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                classes[i] = this->classify(argv[i]);
+            }
+        });
+    }
+    for (auto &thread: threads)
+    {
+        thread.join();
+    }
+    return classes;
+}
+
+CCLIP_INLINE void cclip::options_manager::set_parallel_threshold(const size_t threshold)
+{
+    this->parallel_threshold = threshold;
+}
+
+CCLIP_INLINE const cclip::option *cclip::options_manager::find_option(const std::string_view name) const
+{
+    const std::int32_t index = this->names.find(name);
+    return index < 0 ? nullptr : this->options[index];
+}
+
+CCLIP_INLINE std::vector<cclip::suggestion> cclip::options_manager::suggest(const std::string &name, const size_t max_results) const
+{
+    return this->suggestions.find(name, max_results);
+}
+
+CCLIP_INLINE const std::vector<cclip::option *> &cclip::options_manager::get_options() const
+{
+    return this->options;
+}
+
+CCLIP_INLINE const cclip::parse_result &cclip::options_manager::get_result() const
+{
+    return this->result;
+}
+
+CCLIP_INLINE char *cclip::options_manager::build_autocomplete_ps1() const
+{
+    if (this->command_name.empty())
+    {
+        throw std::runtime_error("Command name is not set, make sure to run after parsing the command line arguments.");
+    }
+    std::string options;
+
+    for (const auto &option: this->options)
+    {
+        if (option->short_name[0])
+        {
+            options += "'-";
+            options += option->short_name;
+            options += "', ";
+        }
+
+        if (option->long_name[0])
+        {
+            options += "'--";
+            options += option->long_name;
+            options += "', ";
+        }
+    }
+    options = options.substr(0, options.length() - 2); // Remove the trailing comma and space
+
+    // Map every spelling of a choice option to the values it accepts
+    std::string choices;
+    for (const auto &option: this->options)
+    {
+        if (option->choices == nullptr)
+        {
+            continue;
+        }
+        std::string values;
+        for (const auto &value: option->choices->get_choices())
+        {
+            values += "'";
+            values += value.name;
+            values += "', ";
+        }
+        values = values.substr(0, values.length() - 2);
+        if (option->short_name[0])
+        {
+            choices += "'-" + std::string(option->short_name) + "' = @(" + values + "); ";
+        }
+        if (option->long_name[0])
+        {
+            choices += "'--" + std::string(option->long_name) + "' = @(" + values + "); ";
+        }
+    }
+
+    std::string ps1 =
+            "# " + std::string(this->context) + " command-line autocomplete\n"
+            "Register-ArgumentCompleter -Native -CommandName '" + this->command_name + "' -ScriptBlock {\n"
+            "param($wordToComplete, $commandAst, $cursorPosition)\n"
+            "$options = " + options + "\n"
+            "$choices = @{ " + choices + "}\n\n"
+            "$previous = $commandAst.CommandElements | Where-Object { $_.Extent.EndOffset -lt $cursorPosition } | Select-Object -Last 1\n"
+            "if ($previous -and $choices.ContainsKey($previous.ToString())) {\n"
+            "$choices[$previous.ToString()] | Where-Object { $_ -like \"$wordToComplete*\" } | ForEach-Object {\n"
+            "[System.Management.Automation.CompletionResult]::new($_, $_, 'ParameterValue', $_)\n"
+            "}\n"
+            "return\n"
+            "}\n"
+            "$options | Where-Object { $_ -like \"$wordToComplete*\" } | ForEach-Object {\n"
+            "[System.Management.Automation.CompletionResult]::new($_, $_, 'ParameterName', $_)\n"
+            "}\n"
+            "}\n";
+    return strdup(ps1.c_str());
+}
+
+
+CCLIP_INLINE void cclip::parse_result::reset(const size_t option_count)
+{
+    this->present.assign((option_count + 63) / 64, 0);
+    this->arguments.assign(option_count, nullptr);
+    this->choice_values.assign(option_count, -1);
+    this->operands = operand_span();
+}
+
+CCLIP_INLINE void cclip::parse_result::set(const std::uint32_t index, char *argument, const int choice_value)
+{
+    this->present[index / 64] |= std::uint64_t{1} << (index % 64);
+    if (argument != nullptr)
+    {
+        this->arguments[index] = argument;
+        this->choice_values[index] = choice_value;
+    }
+}
+
+CCLIP_INLINE void cclip::parse_result::set_operands(const operand_span operands)
+{
+    this->operands = operands;
+}
+
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+CCLIP_INLINE void cclip::suggestion_index::add(const char *name, const std::uint32_t option, const bool is_long)
+{
+    const size_t length = std::strlen(name);
+    const auto id = static_cast<std::uint32_t>(this->entries.size());
+    const posting added{character_set(name, length), id, static_cast<std::uint32_t>(length)};
+    this->entries.push_back(entry{name, length, option, is_long});
+    if (length >= this->buckets.size())
+    {
+        this->buckets.resize(length + 1);
+    }
+    this->buckets[length].push_back(added);
+    for (size_t i = 0; i + 1 < length; ++i)
+    {
+        if (length <= max_bigram_length)
+        {
+            this->index_gram(gram(name + i, 2), added);
+        }
+        if (i + 2 < length)
+        {
+            this->index_gram(gram(name + i, 3), added);
+        }
+    }
+}
+
+CCLIP_INLINE void cclip::suggestion_index::index_gram(const std::uint32_t key, const posting &added)
+{
+    size_t position = this->find_gram(key);
+    if (position == this->gram_slots.size())
+    {
+        const auto list = static_cast<std::uint32_t>(this->postings.size());
+        this->postings.emplace_back();
+        if (this->postings.size() * 2 > this->gram_slots.size())
+        {
+            std::vector<gram_slot> previous(this->gram_slots.empty() ? 64 : this->gram_slots.size() * 2, gram_slot{0, 0, 0});
+            previous.swap(this->gram_slots);
+            for (const gram_slot &slot: previous)
+            {
+                if (slot.key != 0)
+                {
+                    this->place(slot);
+                }
+            }
+        }
+        this->place(gram_slot{key, list, 0});
+        position = this->find_gram(key);
+    }
+    // Keep the list sorted by length, this entry goes after every name as long as its own, where it already is if the name repeats the gram
+    gram_slot &slot = this->gram_slots[position];
+    std::vector<posting> &list = this->postings[slot.list];
+    const auto insert_at = std::upper_bound(list.begin(), list.end(), added.length, [](const size_t value, const posting &p) { return value < p.length; });
+    if (insert_at == list.begin() || std::prev(insert_at)->entry != added.entry)
+    {
+        list.insert(insert_at, added);
+        slot.size = static_cast<std::uint32_t>(list.size());
+    }
+}
+
+CCLIP_INLINE std::uint32_t cclip::suggestion_index::gram(const char *text, const size_t size)
+{
+    // A bigram is marked above the 24 bits of a trigram, whose first character is never null, so the two never share a key
+    const auto byte = [text](const size_t i) { return static_cast<std::uint32_t>(static_cast<unsigned char>(text[i])); };
+    return size == 2 ? 1u << 24 | byte(0) << 8 | byte(1) : byte(0) << 16 | byte(1) << 8 | byte(2);
+}
+
+CCLIP_INLINE size_t cclip::suggestion_index::home(const std::uint32_t key) const
+{
+    // Fibonacci hashing, folding the well mixed high bits of the product into the low ones
+    const std::uint32_t hash = key * 2654435769u;
+    return (hash ^ hash >> 15) & (this->gram_slots.size() - 1);
+}
+
+CCLIP_INLINE void cclip::suggestion_index::place(const gram_slot &slot)
+{
+    const size_t mask = this->gram_slots.size() - 1;
+    size_t position = this->home(slot.key);
+    while (this->gram_slots[position].key != 0)
+    {
+        position = (position + 1) & mask;
+    }
+    this->gram_slots[position] = slot;
+}
+
+CCLIP_INLINE size_t cclip::suggestion_index::find_gram(const std::uint32_t key) const
+{
+    // The position of the slot, or the size of the table if no name has the gram
+    if (this->gram_slots.empty())
+    {
+        return 0;
+    }
+    const size_t mask = this->gram_slots.size() - 1;
+    for (size_t position = this->home(key); this->gram_slots[position].key != 0; position = (position + 1) & mask)
+    {
+        if (this->gram_slots[position].key == key)
+        {
+            return position;
+        }
+    }
+    return this->gram_slots.size();
 }
 
-inline void cclip::options_manager::add_example_usage(const char *example_usage)
+CCLIP_INLINE std::uint64_t cclip::suggestion_index::character_set(const char *text, const size_t length)
 {
-    this->example_usages.push_back(example_usage);
+    std::uint64_t set = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+        set |= std::uint64_t{1} << (static_cast<unsigned char>(text[i]) & 63);
+    }
+    return set;
 }
 
-inline void cclip::options_manager::set_version(const char *version)
-{
-    this->version = version;
-}
 
-inline const char *cclip::options_manager::get_version()
+CCLIP_INLINE size_t cclip::suggestion_index::distance(const unsigned char *slots, const std::uint64_t *peq, const char *pattern, const size_t pattern_length, const char *text, const size_t text_length, const size_t limit)
 {
-    return this->version;
-}
+    // A common prefix and suffix do not change the distance, and names that share words often differ in a few characters in between
+    size_t prefix = 0;
+    while (prefix < pattern_length && prefix < text_length && pattern[prefix] == text[prefix])
+    {
+        ++prefix;
+    }
+    size_t suffix = 0;
+    while (prefix + suffix < pattern_length && prefix + suffix < text_length && pattern[pattern_length - 1 - suffix] == text[text_length - 1 - suffix])
+    {
+        ++suffix;
+    }
+    const size_t middle = pattern_length - prefix - suffix;
+    const size_t end = text_length - suffix;
+    if (middle == 0 || prefix == end)
+    {
+        return middle + (end - prefix);
+    }
 
-inline void cclip::options_manager::print_version() const
-{
-    if (this->version != nullptr)
+    // Myers' bit-vector algorithm with Hyyrö's change for the edit distance of the whole strings rather than a substring search. Shifting
+    // out the prefix is enough, bits above the middle of the pattern never reach the highest bit that is read
+    std::uint64_t pv = ~std::uint64_t{0};
+    std::uint64_t mv = 0;
+    const std::uint64_t high = std::uint64_t{1} << (middle - 1);
+    size_t score = middle;
+    for (size_t i = prefix; i < end; ++i)
     {
-        std::cout <<
-#ifdef ANSIConsoleColors
-                    colors::ConsoleColors::GetColorCode(colors::ColorCodes::Green) <<
-#endif
-                this->context << " " <<
-#ifdef ANSIConsoleColors
-                    colors::ConsoleColors::GetColorCode(colors::ColorCodes::Yellow) <<
-#endif
-                this->version <<
-#ifdef ANSIConsoleColors
-                    colors::ConsoleColors::GetColorCode(colors::ColorCodes::Default) <<
-#endif
-                std::endl;
+        const std::uint64_t eq = peq[slots[static_cast<unsigned char>(text[i])]] >> prefix;
+        const std::uint64_t xv = eq | mv;
+        const std::uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        std::uint64_t ph = mv | ~(xh | pv);
+        std::uint64_t mh = pv & xh;
+        // Branch free, whether the score goes up or down depends on the text and would be mispredicted often
+        score += static_cast<size_t>((ph & high) != 0) - static_cast<size_t>((mh & high) != 0);
+        // The score drops by at most one per remaining character, stop once the limit is out of reach
+        if (score > limit + (end - i - 1))
+        {
+            return limit + 1;
+        }
+        ph = ph << 1 | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
     }
+    return score;
 }
 
-inline void cclip::options_manager::print_examples() const
+CCLIP_INLINE std::vector<cclip::suggestion> cclip::suggestion_index::find(const std::string_view name, const size_t max_results) const
 {
-    std::cout <<
-#ifdef ANSIConsoleColors
-                colors::ConsoleColors::GetColorCode(colors::ColorCodes::Yellow) <<
-#endif
-            "Example Usages:" <<
-#ifdef ANSIConsoleColors
-                colors::ConsoleColors::GetColorCode(colors::ColorCodes::Blue) <<
-#endif
-            std::endl;
-    for (const auto &example_usage: this->example_usages)
+    std::vector<suggestion> results;
+    const size_t length = std::min<size_t>(name.size(), 64);
+    if (length == 0 || max_results == 0)
     {
-        std::cout <<
-                example_usage <<
-                std::endl;
+        return results;
     }
 
-#ifdef ANSIConsoleColors
-        colors::ConsoleColors::ResetConsoleColor();
-#endif
-}
+    // The positions of each character of the name, through a byte per character so there is less to clear; slot 0 is every other character.
+    // A character seen for the first time takes the next slot without a branch, which would be mispredicted all along the name
+    unsigned char slots[256] = {};
+    std::uint64_t peq[65] = {};
+    size_t used = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+        unsigned char &slot = slots[static_cast<unsigned char>(name[i])];
+        const size_t first = slot == 0;
+        used += first;
+        slot = static_cast<unsigned char>(slot | (used & (0 - first)));
+        peq[slot] |= std::uint64_t{1} << i;
+    }
 
-inline cclip::option *cclip::options_manager::add_option(const char *short_name, const char *long_name, const char *description, const bool is_required, const bool has_argument, const bool executes_before_requires)
-{
-    auto *opt = new option{short_name, long_name, description, is_required, has_argument, executes_before_requires, nullptr};
-    this->options.push_back(opt);
-    return opt;
-}
+    const std::uint64_t characters = character_set(name.data(), length);
+    // A third of the length like rustc and cargo, so a short name is not matched with everything that shares a letter or two
+    size_t limit = std::min<size_t>(std::max<size_t>(length, 3) / 3, 3);
+    // Every edit adds or removes at most one distinct character, so a name lacking more than limit of the characters, or having more than
+    // limit others, is too far away; clearing the lowest set bit limit times counts that far without a popcount instruction
+    const auto too_different = [characters, &limit](const std::uint64_t candidate)
+    {
+        std::uint64_t missing = characters & ~candidate;
+        std::uint64_t extra = candidate & ~characters;
+        for (size_t i = 0; i < limit; ++i)
+        {
+            missing &= missing - 1;
+            extra &= extra - 1;
+        }
+        return (missing | extra) != 0;
+    };
+    // The best matches so far with their rank: the distance, then closest in length, longer before shorter, then the order the names were
+    // added in, so the result does not depend on the order the candidates are visited in. Kept on the stack for the usual few results
+    using ranked = std::pair<std::uint64_t, std::uint32_t>;
+    ranked inline_best[8];
+    std::vector<ranked> spilled;
+    ranked *best = inline_best;
+    if (max_results >= std::size(inline_best))
+    {
+        spilled.resize(max_results + 1);
+        best = spilled.data();
+    }
+    size_t best_count = 0;
+    const auto consider = [&](const posting &p)
+    {
+        const size_t difference = p.length >= length ? p.length - length : length - p.length;
+        // Both tests are made before the one branch, most candidates fail one of them and which one is hard to predict
+        if ((difference > limit) | too_different(p.characters))
+        {
+            return;
+        }
+        if (std::any_of(best, best + best_count, [&p](const ranked &b) { return b.second == p.entry; }))
+        {
+            return;
+        }
+        const entry &candidate = this->entries[p.entry];
+        const size_t d = distance(slots, peq, name.data(), length, candidate.name, candidate.length, limit);
+        if (d > limit)
+        {
+            return;
+        }
+        const std::uint64_t order = p.length >= length ? 2 * difference : 2 * difference + 1;
+        const ranked current{std::uint64_t{d} << 56 | order << 32 | p.entry, p.entry};
+        ranked *const same_option = std::find_if(best, best + best_count, [this, &candidate](const ranked &b) { return this->entries[b.second].option == candidate.option; });
+        if (same_option != best + best_count)
+        {
+            if (same_option->first <= current.first)
+            {
+                return;
+            }
+            std::copy(same_option + 1, best + best_count, same_option);
+            --best_count;
+        }
+        ranked *const position = std::upper_bound(best, best + best_count, current);
+        std::copy_backward(position, best + best_count, best + best_count + 1);
+        *position = current;
+        best_count = std::min(best_count + 1, max_results);
+        if (best_count == max_results)
+        {
+            limit = static_cast<size_t>(best[best_count - 1].first >> 56);
+        }
+    };
+    const auto finish = [&]
+    {
+        results.reserve(best_count);
+        for (size_t i = 0; i < best_count; ++i)
+        {
+            const entry &e = this->entries[best[i].second];
+            results.push_back(suggestion{e.name, e.is_long, e.option, static_cast<size_t>(best[i].first >> 56)});
+        }
+        return results;
+    };
 
-inline void cclip::options_manager::parse(const int argc, char **argv)
-{
-    this->command_name = std::filesystem::path(argv[0]).stem().string(); // Get the executable name
-    for (int i = 0; i < argc; ++i)
+    // An edit changes at most one of a set of pieces that do not overlap, so a match contains one of any limit + 1 of them. Pick the bigrams
+    // and trigrams whose posting lists are the shortest in total, a piece that no name has being the best pick
+    const size_t needed = limit + 1;
+    const size_t shortest = length > limit ? length - limit : 1;
+    if (length >= 2 * needed)
     {
-        if (const char *arg = argv[i]; arg[0] == '-')
+        // A piece no name has is kept as a slot with an empty list
+        const gram_slot missing{0, 0, 0};
+        const gram_slot *bigrams[63];
+        const gram_slot *trigrams[62];
+        const auto lookup = [this, &missing](const std::uint32_t key)
         {
-            if (arg[1] == '-')
+            const size_t position = this->find_gram(key);
+            return position == this->gram_slots.size() ? &missing : &this->gram_slots[position];
+        };
+        // Trigrams alone are enough once the name is long enough for them, which saves half of the lookups. That is from 12 characters on,
+        // so the bigram lists only need the names up to 3 edits longer
+        const bool use_bigrams = length < 3 * needed;
+        size_t cost[65][5]; // the smallest total for j pieces that all end before i
+        const size_t none = ~size_t{0} >> 2;
+        // The lookups do not depend on each other, done apart from the sums they overlap in the pipeline
+        for (size_t i = 0; i + 2 < length; ++i)
+        {
+            trigrams[i] = lookup(gram(name.data() + i, 3));
+        }
+        for (size_t i = 0; use_bigrams && i + 1 < length; ++i)
+        {
+            bigrams[i] = lookup(gram(name.data() + i, 2));
+        }
+        for (size_t i = 0; i <= length; ++i)
+        {
+            cost[i][0] = 0;
+            for (size_t j = 1; j <= needed; ++j)
             {
-                // long option
-                const char *name = arg + 2;
-                if (option *opt = this->get_option_from_global_list(name); opt == nullptr)
+                cost[i][j] = i == 0 ? none : cost[i - 1][j];
+                if (use_bigrams && i >= 2)
                 {
-#ifdef ANSIConsoleColors
-                        colors::ConsoleColors::SetForegroundColor(colors::ColorCodes::Red);
-#endif
-                    std::cerr << "Unknown option: --" << name << std::endl;
-#ifdef ANSIConsoleColors
-                        colors::ConsoleColors::ResetConsoleColor();
-#endif
-                    this->print_help();
-                    exit(1);
-                } else
+                    cost[i][j] = std::min(cost[i][j], cost[i - 2][j - 1] + bigrams[i - 2]->size);
+                }
+                if (i >= 3)
                 {
-                    if (opt->has_argument)
-                    {
-                        if (i + 1 >= argc)
-                        {
-#ifdef ANSIConsoleColors
-                                colors::ConsoleColors::SetForegroundColor(colors::ColorCodes::Red);
-#endif
-                            std::cerr << "Missing argument for option: " << name << std::endl;
-
-#ifdef ANSIConsoleColors
-                                colors::ConsoleColors::ResetConsoleColor();
-#endif
-                            this->print_help();
-                            exit(1);
-                        }
-                        opt->argument = argv[i + 1];
-                    }
-                    this->present_options.push_back(opt);
+                    cost[i][j] = std::min(cost[i][j], cost[i - 3][j - 1] + trigrams[i - 3]->size);
                 }
-            } else
+            }
+        }
+
+        const std::vector<posting> *chosen[4];
+        size_t chosen_count = 0;
+        for (size_t i = length, j = needed; j > 0;)
+        {
+            if (cost[i][j] == cost[i - 1][j])
             {
-                // short option
-                const char *name = arg + 1;
-                if (option *opt = this->get_option_from_global_list(name); opt == nullptr)
-                {
-                    std::cerr << "Unknown option: -" << name << std::endl;
-                    this->print_help();
-                    exit(1);
-                } else
+                --i;
+                continue;
+            }
+            const bool is_bigram = use_bigrams && cost[i][j] == cost[i - 2][j - 1] + bigrams[i - 2]->size;
+            const gram_slot *slot = is_bigram ? bigrams[i - 2] : trigrams[i - 3];
+            i -= is_bigram ? 2 : 3;
+            --j;
+            if (slot->size != 0)
+            {
+                chosen[chosen_count++] = &this->postings[slot->list];
+            }
+        }
+        size_t scan_size = 0;
+        for (size_t candidate_length = shortest; candidate_length <= length + limit && candidate_length < this->buckets.size(); ++candidate_length)
+        {
+            scan_size += this->buckets[candidate_length].size();
+        }
+
+        if (cost[length][needed] < scan_size)
+        {
+            // A name in several of the lists is met more than once, which the ranking makes harmless. The lists are short and sorted by
+            // length, so walking up to the longest nearby length is cheaper than searching for the nearby range
+            for (size_t i = 0; i < chosen_count; ++i)
+            {
+                for (const posting &p: *chosen[i])
                 {
-                    if (opt->has_argument)
+                    if (p.length > length + limit)
                     {
-                        if (i + 1 >= argc)
-                        {
-                            std::cerr << "Missing argument for option: " << name << std::endl;
-                            this->print_help();
-                            exit(1);
-                        }
-                        opt->argument = argv[i + 1];
+                        break;
                     }
-                    this->present_options.push_back(opt);
+                    consider(p);
                 }
             }
+            return finish();
         }
     }
-    bool ignore_missing = false;
-    for (const auto &option: this->options)
-    {
-        if (option->executes_before_requires && this->is_present(option->short_name))
-        {
-            ignore_missing = true;
-            break;
-        }
-    }
-    if (!ignore_missing)
+
+    for (size_t offset = 0; offset <= limit; ++offset)
     {
-        bool missing = false;
-        for (const auto &option: this->options)
+        const size_t lengths[2] = {length + offset, length - offset};
+        for (size_t side = 0; side < (offset == 0 ? 1 : 2); ++side)
         {
-            if (option->is_required && !this->is_present(option->short_name))
+            const size_t candidate_length = lengths[side];
+            if ((side == 1 && offset >= length) || candidate_length >= this->buckets.size())
             {
-#ifdef ANSIConsoleColors
-                colors::ConsoleColors::SetForegroundColor(colors::ColorCodes::Red);
-#endif
-                std::cerr << "Missing required option: -" << option->short_name << " or --" << option->long_name << std::endl;
-#ifdef ANSIConsoleColors
-                colors::ConsoleColors::ResetConsoleColor();
-#endif
-                missing = true;
+                continue;
+            }
+            for (const posting &p: this->buckets[candidate_length])
+            {
+                consider(p);
             }
-        }
-        if (missing)
-        {
-            this->print_help();
-            exit(1);
         }
     }
+    return finish();
 }
 
-inline void cclip::options_manager::print_help(const bool print_examples) const
-{
-    const char *help = this->get_help();
-    if (print_examples)
-    {
-        this->print_examples();
-    }
-    std::cout << help << std::endl;
-    delete(help); // Deletes the memory allocated by get_help()
-}
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CCLIP_UTF8_SSE2 1
+#endif
 
-inline const char *cclip::options_manager::get_help() const
+CCLIP_INLINE std::int32_t cclip::detail::decode_utf8(const unsigned char *&position, const unsigned char *end)
 {
-    std::stringstream buf;
-    buf <<
-#ifdef ANSIConsoleColors
-                colors::ConsoleColors::GetColorCode(colors::ColorCodes::Magenta) <<
-#endif
-            this->context << " Help:\n";
-    if (this->description != nullptr)
+    const unsigned char lead = position[0];
+    if (lead < 0x80)
     {
-        buf <<
-#ifdef ANSIConsoleColors
-                colors::ConsoleColors::GetColorCode(colors::ColorCodes::LightGray) <<
-#endif
-                this->description << "\n";
+        ++position;
+        return lead;
     }
 
-    for (auto &option: this->options)
+    // The lead byte decides the length and the range of the second byte, which rules out overlong encodings, surrogates and code points above U+10FFFF
+    size_t length;
+    unsigned char low = 0x80;
+    unsigned char high = 0xBF;
+    std::int32_t code_point;
+    if (lead < 0xC2)
     {
-        if (option->short_name[0])
+        ++position; // a continuation byte, or an overlong two byte sequence
+        return -1;
+    }
+    if (lead < 0xE0)
+    {
+        length = 2;
+        code_point = lead & 0x1F;
+    } else if (lead < 0xF0)
+    {
+        length = 3;
+        code_point = lead & 0x0F;
+        low = lead == 0xE0 ? 0xA0 : 0x80;
+        high = lead == 0xED ? 0x9F : 0xBF;
+    } else if (lead < 0xF5)
+    {
+        length = 4;
+        code_point = lead & 0x07;
+        low = lead == 0xF0 ? 0x90 : 0x80;
+        high = lead == 0xF4 ? 0x8F : 0xBF;
+    } else
+    {
+        ++position;
+        return -1;
+    }
+    if (static_cast<size_t>(end - position) < length || position[1] < low || position[1] > high)
+    {
+        ++position;
+        return -1;
+    }
+    for (size_t i = 1; i < length; ++i)
+    {
+        if (i > 1 && (position[i] & 0xC0) != 0x80)
         {
-            buf <<
-#ifdef ANSIConsoleColors
-                    colors::ConsoleColors::GetColorCode(colors::ColorCodes::Blue) <<
-#endif
-                    "-" << option->short_name;
-            if (option->long_name[0])
-                buf << ", ";
+            ++position;
+            return -1;
         }
+        code_point = code_point << 6 | (position[i] & 0x3F);
+    }
+    position += length;
+    return code_point;
+}
 
-        if (option->long_name[0])
-        {
-            buf <<
-#ifdef ANSIConsoleColors
-                    colors::ConsoleColors::GetColorCode(colors::ColorCodes::Cyan) <<
-#endif
-                    "--" << option->long_name;
-        }
+CCLIP_INLINE size_t cclip::detail::code_point_width(const std::int32_t code_point)
+{
+    struct range
+    {
+        std::int32_t first;
+        std::int32_t last;
+    };
 
-        if (option->has_argument)
-        {
-            buf << " <arg>";
-        }
-        if (option->is_required)
+    // Combining marks, format and zero-width characters, variation selectors and emoji modifiers
+    static constexpr range zero_width[] = {
+        {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x05BF, 0x05BF}, {0x05C1, 0x05C2}, {0x05C4, 0x05C5}, {0x05C7, 0x05C7},
+        {0x0610, 0x061A}, {0x064B, 0x065F}, {0x0670, 0x0670}, {0x06D6, 0x06DC}, {0x06DF, 0x06E4}, {0x06E7, 0x06E8}, {0x06EA, 0x06ED},
+        {0x0900, 0x0902}, {0x093A, 0x093A}, {0x093C, 0x093C}, {0x0941, 0x0948}, {0x094D, 0x094D}, {0x0951, 0x0957}, {0x0E31, 0x0E31},
+        {0x0E34, 0x0E3A}, {0x0E47, 0x0E4E}, {0x1160, 0x11FF}, {0x1AB0, 0x1AFF}, {0x1DC0, 0x1DFF}, {0x200B, 0x200F}, {0x202A, 0x202E},
+        {0x2060, 0x2064}, {0x20D0, 0x20FF}, {0x302A, 0x302D}, {0x3099, 0x309A}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F}, {0xFEFF, 0xFEFF},
+        {0x1F3FB, 0x1F3FF}, {0xE0001, 0xE007F}, {0xE0100, 0xE01EF},
+    };
+    // East Asian wide and fullwidth characters and emoji shown in emoji presentation
+    static constexpr range wide[] = {
+        {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC}, {0x23F0, 0x23F0}, {0x23F3, 0x23F3}, {0x25FD, 0x25FE},
+        {0x2614, 0x2615}, {0x2648, 0x2653}, {0x267F, 0x267F}, {0x2693, 0x2693}, {0x26A1, 0x26A1}, {0x26AA, 0x26AB}, {0x26BD, 0x26BE},
+        {0x26C4, 0x26C5}, {0x26CE, 0x26CE}, {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5}, {0x26FA, 0x26FA},
+        {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B}, {0x2728, 0x2728}, {0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755},
+        {0x2757, 0x2757}, {0x2795, 0x2797}, {0x27B0, 0x27B0}, {0x27BF, 0x27BF}, {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55},
+        {0x2E80, 0x303E}, {0x3041, 0x33FF}, {0x3400, 0x4DBF}, {0x4E00, 0x9FFF}, {0xA000, 0xA4CF}, {0xA960, 0xA97F}, {0xAC00, 0xD7A3},
+        {0xF900, 0xFAFF}, {0xFE10, 0xFE19}, {0xFE30, 0xFE6F}, {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x16FE0, 0x16FE4}, {0x17000, 0x18AFF},
+        {0x1B000, 0x1B2FF}, {0x1F004, 0x1F004}, {0x1F0CF, 0x1F0CF}, {0x1F18E, 0x1F18E}, {0x1F191, 0x1F19A}, {0x1F200, 0x1F251},
+        {0x1F300, 0x1F64F}, {0x1F680, 0x1F6FF}, {0x1F7E0, 0x1F7EB}, {0x1F90C, 0x1F9FF}, {0x1FA70, 0x1FAFF}, {0x20000, 0x2FFFD},
+        {0x30000, 0x3FFFD},
+    };
+
+    const auto contains = [code_point](const range *first, const range *end) {
+        // binary search for the first range that ends at or after the code point
+        const range *last = end;
+        while (first < last)
         {
-            buf <<
-#ifdef ANSIConsoleColors
-                        colors::ConsoleColors::GetColorCode(colors::ColorCodes::Red)
-                        <<
-#endif
-                    " (required)";
+            const range *middle = first + (last - first) / 2;
+            if (middle->last < code_point)
+            {
+                first = middle + 1;
+            } else
+            {
+                last = middle;
+            }
         }
+        return first != end && first->first <= code_point;
+    };
 
-        buf <<
-#ifdef ANSIConsoleColors
-                    colors::ConsoleColors::GetColorCode(colors::ColorCodes::LightGray)
-                    <<
-#endif
-                "\n\t" << option->description << "\n";
+    if (code_point < 0x20 || (code_point >= 0x7F && code_point < 0xA0))
+    {
+        return 0;
     }
-
-#ifdef ANSIConsoleColors
-        buf << colors::ConsoleColors::GetColorCode(colors::ColorCodes::Default);
-#endif
-
-    const size_t length = buf.str().length() + 1;
-    const auto help_str = new char[length];
-    strcpy(help_str, buf.str().c_str());
-    return help_str;
-}
-
-inline bool cclip::options_manager::is_present(const std::string &name) const
-{
-    return std::any_of(this->present_options.begin(), this->present_options.end(), [&name](const option *opt)
+    if (code_point < 0x300)
     {
-        return opt->short_name == name || opt->long_name == name;
-    });
+        return 1;
+    }
+    if (contains(std::begin(zero_width), std::end(zero_width)))
+    {
+        return 0;
+    }
+    return contains(std::begin(wide), std::end(wide)) ? 2 : 1;
 }
 
-inline cclip::option *cclip::options_manager::get_option(const std::string &name)
+CCLIP_INLINE bool cclip::is_valid_utf8(const std::string_view text)
 {
-    for (const auto &option: this->present_options)
+    const auto *position = reinterpret_cast<const unsigned char *>(text.data());
+    const unsigned char *end = position + text.size();
+#ifdef CCLIP_UTF8_SSE2
+    while (end - position >= 16)
     {
-        if (option->short_name == name || option->long_name == name)
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(position));
+        if (_mm_movemask_epi8(chunk) == 0)
+        {
+            position += 16; // all ASCII
+            continue;
+        }
+        const unsigned char *chunk_end = position + 16;
+        while (position < chunk_end)
         {
-            return option;
+            if (detail::decode_utf8(position, end) < 0)
+            {
+                return false;
+            }
         }
     }
-    return nullptr;
-}
-
-inline cclip::option *cclip::options_manager::get_option_from_global_list(const std::string &name)
-{
-    for (const auto &option: this->options)
+#endif
+    while (position < end)
     {
-        if (std::strcmp(option->short_name, name.c_str()) == 0 || std::strcmp(option->long_name, name.c_str()) == 0)
+        if (detail::decode_utf8(position, end) < 0)
         {
-            return option;
+            return false;
         }
     }
-    return nullptr;
+    return true;
 }
 
-char *cclip::options_manager::build_autocomplete_ps1() const
+CCLIP_INLINE size_t cclip::display_width(const std::string_view text)
 {
-    if (this->command_name.empty())
-    {
-        throw std::runtime_error("Command name is not set, make sure to run after parsing the command line arguments.");
-    }
-    std::string options;
-
-    for (const auto &option: this->options)
+    const auto *position = reinterpret_cast<const unsigned char *>(text.data());
+    const unsigned char *end = position + text.size();
+    size_t width = 0;
+#ifdef CCLIP_UTF8_SSE2
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i del = _mm_set1_epi8(0x7F);
+    while (end - position >= 16)
     {
-        if (option->short_name[0])
+        // Bytes below a space compare as less in a signed compare, and so do the bytes of multi-byte sequences, leaving printable ASCII
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(position));
+        if ((_mm_movemask_epi8(_mm_cmplt_epi8(chunk, space)) | _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, del))) == 0)
         {
-            options += "'-";
-            options += option->short_name;
-            options += "', ";
+            position += 16;
+            width += 16;
+            continue;
         }
-
-        if (option->long_name[0])
+        const unsigned char *chunk_end = position + 16;
+        while (position < chunk_end)
         {
-            options += "'--";
-            options += option->long_name;
-            options += "', ";
+            const std::int32_t code_point = detail::decode_utf8(position, end);
+            width += code_point < 0 ? 1 : detail::code_point_width(code_point);
         }
     }
-    options = options.substr(0, options.length() - 2); // Remove the trailing comma and space
-
-    std::string ps1 =
-            "# " + std::string(this->context) + " command-line autocomplete\n"
-            "Register-ArgumentCompleter -CommandName '" + this->command_name + "' -ScriptBlock {\n"
-            "param($commandName, $wordToComplete, $cursorPosition)\n"
-            "$options = " + options + "\n\n"
-            "$options | Where-Object { $_ -like \"$wordToComplete * \" } | ForEach-Object {\n"
-            "[System.Management.Automation.CompletionResult]::new($_, $_, 'ParameterName', $_)\n"
-            "}\n"
-            "}\n";
-    return strdup(ps1.c_str());
+#endif
+    while (position < end)
+    {
+        const std::int32_t code_point = detail::decode_utf8(position, end);
+        width += code_point < 0 ? 1 : detail::code_point_width(code_point);
+    }
+    return width;
 }
+
+#endif
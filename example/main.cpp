@@ -2,47 +2,60 @@
 #include "../cclip.hpp"
 #include <iostream>
 
+enum class file_format
+{
+    text,
+    json,
+    xml
+};
+
 int main(const int argc, char **argv)
 {
     cclip::options_manager manager("CCLIP Example", "This is an example of the cclip library. cclip library is a lightweight command-line argument parsing tool for C++ applications.");
     // These will run even if the required options are not present
-    manager.add_option("h", "help", "Print this help message", false, false, true);
-    manager.add_option("v", "version", "Print the version", false, false, true);
+    const cclip::option_handle help = manager.add_option("h", "help", "Print this help message", false, false, true);
+    const cclip::option_handle version = manager.add_option("v", "version", "Print the version", false, false, true);
 
-    manager.add_option("V", "verbose", "Prints to the console verbosly", false, false);
-    manager.add_option("f", "file", "The file to read", true, true);
-    manager.add_option("", "format", "The format of the file", false, true);
+    const cclip::option_handle verbose = manager.add_option("V", "verbose", "Prints to the console verbosly", false, false);
+    const cclip::option_handle file = manager.add_option("f", "file", "The file to read", true, true);
+    const cclip::option_handle format = manager.add_choice_option("", "format", "The format of the file", false, {{"text", file_format::text}, {"json", file_format::json}, {"xml", file_format::xml}});
 
     manager.set_version(CCLIP_VERSION);
     manager.add_example_usage(R"(-f C:\Users\user\Desktop\file.txt)");
     manager.add_example_usage(R"(-f "C:\Users\user with space\Desktop\file.txt")");
 
+    // Handlers run while parsing, and help and version stop the parse as soon as they are seen
+    manager.on(help, [&manager](const char *) { manager.print_help(); });
+    manager.on(version, [&manager](const char *) { manager.print_version(); });
 
-
-    manager.parse(argc, argv);
-    std::cout << manager.build_autocomplete_ps1() << std::endl;
-
-    if (manager.is_present("h"))
+    if (!manager.parse(argc, argv))
     {
-        manager.print_help();
         return 0;
     }
+    std::cout << manager.build_autocomplete_ps1() << std::endl;
 
-    if (manager.is_present("v"))
+    if (manager.is_present(verbose))
     {
-        manager.print_version();
-        return 0;
+        std::cout << "This is verbose mode" << std::endl;
     }
 
-    if (manager.is_present("V"))
+
+    if (manager.get(file) != nullptr)
     {
-        std::cout << "This is verbose mode" << std::endl;
+        std::cout << "File: " << manager.get(file) << std::endl;
     }
 
-
-    if (manager.is_present("f") && manager.get_option("f")->argument != nullptr)
+    switch (manager.get_choice(format, file_format::text))
     {
-        std::cout << "File: " << manager.get_option("f")->argument << std::endl;
+        case file_format::text:
+            std::cout << "Format: text" << std::endl;
+            break;
+        case file_format::json:
+            std::cout << "Format: json" << std::endl;
+            break;
+        case file_format::xml:
+            std::cout << "Format: xml" << std::endl;
+            break;
     }
     // system("pause");
 }
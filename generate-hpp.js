@@ -19,17 +19,38 @@ const legalHeader = `/**
 const version= '0.1.0';
 
 let content = '';
-// Include the content of all header files
-for (const include of includes) {
+const emittedIncludes = new Set();
+
+// Include the content of a header file, making sure the local headers it depends on are emitted first
+function emitInclude(include) {
+    if (emittedIncludes.has(include)) return;
+    emittedIncludes.add(include);
     const includeFileContent = fs.readFileSync(path.join(includesDirectory, include), 'utf8');
+    for (const dependency of localIncludesOf(includeFileContent)) {
+        emitInclude(dependency);
+    }
     content += removeLocalIncludes(includeFileContent);
 }
 
-// Include the content of all source files
+// Include the content of all header files
+for (const include of includes) {
+    emitInclude(include);
+}
+
+// Include the content of all source files, these are compiled once by the cclip_static target when CCLIP_HEADER_ONLY is 0
+content += '\n#if CCLIP_HEADER_ONLY\n';
 for (const source of sources) {
     let sourceFileContent = fs.readFileSync(path.join(sourceDirectory, source), 'utf8');
     content += removeLocalIncludes(sourceFileContent);
 }
+content += '\n#endif\n';
+
+function localIncludesOf(content) {
+    const includesFound = content.match(/#include\s*".*"/g) || [];
+    return includesFound
+        .map(include => include.replace(/#include\s*"/, '').replace('"', ''))
+        .filter(includeFile => includes.includes(includeFile));
+}
 
 function removeLocalIncludes(content) {
     const includesFound = content.match(/#include\s*".*"/g);
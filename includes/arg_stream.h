@@ -0,0 +1,137 @@
+#pragma once
+
+#ifndef ARG_STREAM_H
+#define ARG_STREAM_H
+
+#include <cstddef>
+#include <cstdio>
+#include <iterator>
+#include <string_view>
+#include <vector>
+#include "config.h"
+
+namespace cclip
+{
+    /**
+     * Reads arguments from a NUL- or newline-delimited stream, like xargs -0, e.g. for an --args-from option.
+     * Arguments are read through a fixed-size buffer and handed out one at a time as they arrive, so memory stays constant no matter how many there are.
+     * The file descriptor is read directly rather than through stdio, so an argument written to a pipe is handed out without waiting for
+     * the buffer to fill; nothing should be read from the FILE through stdio before.
+     */
+    class arg_stream
+    {
+    public:
+        static constexpr size_t default_capacity = 64 * 1024;
+
+        class iterator
+        {
+        private:
+            arg_stream *stream;
+            std::string_view value;
+
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = std::string_view;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const std::string_view *;
+            using reference = const std::string_view &;
+
+            iterator() : stream(nullptr)
+            {
+            }
+
+            explicit iterator(arg_stream *stream) : stream(stream)
+            {
+                ++*this;
+            }
+
+            reference operator*() const
+            {
+                return this->value;
+            }
+
+            pointer operator->() const
+            {
+                return &this->value;
+            }
+
+            iterator &operator++()
+            {
+                if (!this->stream->next(this->value))
+                {
+                    this->stream = nullptr;
+                }
+                return *this;
+            }
+
+            bool operator==(const iterator &other) const
+            {
+                return this->stream == other.stream;
+            }
+
+            bool operator!=(const iterator &other) const
+            {
+                return this->stream != other.stream;
+            }
+        };
+
+    private:
+        std::FILE *file;
+        bool owns_file;
+        char delimiter;
+        std::vector<char> buffer;
+        size_t begin_offset;
+        size_t end_offset;
+        bool at_end;
+
+        size_t read_some(char *data, size_t count);
+
+    public:
+        /**
+         * Read arguments from an open file. The file is not closed by the stream.
+         * @param file the file to read from, e.g. stdin
+         * @param delimiter the character separating arguments, '\0' or '\n'
+         * @param capacity the size of the buffer, which is also the maximum length of one argument
+         */
+        explicit arg_stream(std::FILE *file, char delimiter = '\0', size_t capacity = default_capacity);
+
+        arg_stream(arg_stream &&other) noexcept;
+
+        arg_stream(const arg_stream &) = delete;
+
+        arg_stream &operator=(const arg_stream &) = delete;
+
+        arg_stream &operator=(arg_stream &&) = delete;
+
+        ~arg_stream();
+
+        /**
+         * Open a file to read arguments from.
+         * @param path the path of the file, or - for stdin
+         * @param delimiter the character separating arguments, '\0' or '\n'
+         * @param capacity the size of the buffer, which is also the maximum length of one argument
+         * @return the stream
+         * @throws std::runtime_error if the file cannot be opened
+         */
+        static arg_stream open(const char *path, char delimiter = '\0', size_t capacity = default_capacity);
+
+        /**
+         * Read the next argument. In newline mode empty lines are skipped and a trailing carriage return is removed.
+         * @param arg set to the argument, it is NUL-terminated and only valid until the next call
+         * @return false once the stream has no more arguments
+         * @throws std::runtime_error if an argument does not fit in the buffer or the stream cannot be read
+         */
+        bool next(std::string_view &arg);
+
+        iterator begin()
+        {
+            return iterator(this);
+        }
+
+        iterator end()
+        {
+            return iterator();
+        }
+    };
+}
+#endif
@@ -0,0 +1,73 @@
+#pragma once
+
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include <cstddef>
+#include <iosfwd>
+#include "callback.h"
+#include "config.h"
+#include "parse_error.h"
+#include "parse_result.h"
+
+namespace cclip
+{
+    class options_manager;
+
+    /**
+     * Runs many invocations in one process by reading command lines from a stream, e.g. stdin or a pipe.
+     * Each command line is split like a shell would (whitespace, quotes and backslashes), parsed against the schema without exiting,
+     * and handed to the application. The next lines are split and parsed on a background thread while the current one is handled; they are
+     * read on the calling thread, ahead of time only while the stream holds buffered input, so a command never waits for the next line.
+     */
+    class batch_runner
+    {
+    public:
+        struct command
+        {
+            /**
+             * The 1-based position of the command line in the input.
+             */
+            size_t line;
+            /**
+             * The number of arguments, including an empty program name in argv[0].
+             */
+            int argc;
+            /**
+             * The arguments, only valid during the call to the handler.
+             */
+            char **argv;
+            /**
+             * The parsed options, only valid during the call to the handler.
+             */
+            const parse_result &result;
+        };
+
+        using command_handler = callback<void(const command &)>;
+        using error_handler = callback<void(size_t line, const parse_error &error)>;
+
+    private:
+        const options_manager &schema;
+        char delimiter;
+
+    public:
+        /**
+         * Create a runner. The schema must outlive the runner.
+         * @param schema the options each command line may contain
+         * @param delimiter the character separating command lines, '\n' or '\0'
+         */
+        explicit batch_runner(const options_manager &schema, char delimiter = '\n');
+
+        /**
+         * Read command lines until the end of the input and dispatch each one. Blank lines are skipped.
+         * If the command handler throws, reading stops and the exception is rethrown.
+         * @param input the stream to read command lines from
+         * @param on_command called on the calling thread for every command line that parsed
+         * @param on_error called on the calling thread for every command line that did not parse, with the error parse_into threw (e.g. an
+         * unknown_option_error with its suggestions), the error is printed to stderr if this is empty
+         * @return the number of command lines that were dispatched to on_command
+         */
+        size_t run(std::istream &input, const command_handler &on_command, const error_handler &on_error = {}) const;
+    };
+}
+#endif
@@ -0,0 +1,205 @@
+#pragma once
+
+#ifndef BINDING_H
+#define BINDING_H
+
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "callback.h"
+#include "option_sink.h"
+#include "options_manager.h"
+#include "parse_error.h"
+#include "parse_result.h"
+
+namespace cclip
+{
+    namespace detail
+    {
+        template<typename M>
+        void convert_argument(M &member, const char *argument, const int choice_value, const std::string &name)
+        {
+            if constexpr (std::is_same_v<M, bool>)
+            {
+                // A flag sets the member, an argument can also clear it
+                if (argument == nullptr || std::strcmp(argument, "true") == 0 || std::strcmp(argument, "1") == 0 || std::strcmp(argument, "yes") == 0 || std::strcmp(argument, "on") == 0)
+                {
+                    member = true;
+                } else if (std::strcmp(argument, "false") == 0 || std::strcmp(argument, "0") == 0 || std::strcmp(argument, "no") == 0 || std::strcmp(argument, "off") == 0)
+                {
+                    member = false;
+                } else
+                {
+                    throw parse_error("Invalid value for option: " + name + " (expected true or false)");
+                }
+            } else if constexpr (std::is_enum_v<M>)
+            {
+                member = static_cast<M>(choice_value);
+            } else if constexpr (std::is_integral_v<M>)
+            {
+                const char *end = argument + std::strlen(argument);
+                const auto [last, error] = std::from_chars(argument, end, member);
+                if (error == std::errc::result_out_of_range)
+                {
+                    throw parse_error("Invalid value for option: " + name + " (out of range)");
+                }
+                if (error != std::errc() || last != end)
+                {
+                    throw parse_error("Invalid value for option: " + name + " (expected an integer)");
+                }
+            } else if constexpr (std::is_floating_point_v<M>)
+            {
+                char *last = nullptr;
+                errno = 0;
+                if constexpr (std::is_same_v<M, float>)
+                {
+                    member = std::strtof(argument, &last);
+                } else if constexpr (std::is_same_v<M, double>)
+                {
+                    member = std::strtod(argument, &last);
+                } else
+                {
+                    member = std::strtold(argument, &last);
+                }
+                if (errno == ERANGE)
+                {
+                    throw parse_error("Invalid value for option: " + name + " (out of range)");
+                }
+                if (last == argument || *last != '\0')
+                {
+                    throw parse_error("Invalid value for option: " + name + " (expected a number)");
+                }
+            } else if constexpr (std::is_same_v<M, std::string> || std::is_same_v<M, std::string_view> || std::is_same_v<M, const char *>)
+            {
+                member = argument == nullptr ? "" : argument;
+            } else
+            {
+                static_assert(!sizeof(M), "Options can only be bound to bool, integer, floating point, enum and string members.");
+            }
+        }
+    }
+
+    /**
+     * Maps the options of a schema onto the members of a plain config struct, so parsing writes converted values straight into it
+     * instead of looking every option up and converting its argument afterwards.
+     * Members can be bool (set by a flag, or true/false/1/0/yes/no/on/off), integers, floating point numbers, enums (bound to a choice option and set to its id),
+     * std::string, or std::string_view and const char *, which point into argv.
+     * @tparam T the config struct
+     */
+    template<typename T>
+    class binding
+    {
+    private:
+        using writer = callback<void(T &target, const char *argument, int choice_value)>;
+
+        class target_sink : public option_sink
+        {
+        private:
+            const std::vector<writer> &fields;
+            T &target;
+
+        public:
+            target_sink(const std::vector<writer> &fields, T &target) : fields(fields), target(target)
+            {
+            }
+
+            void accept(const option_handle handle, const char *argument, const int choice_value) override
+            {
+                if (handle.index < this->fields.size() && this->fields[handle.index])
+                {
+                    this->fields[handle.index](this->target, argument, choice_value);
+                }
+            }
+        };
+
+        const options_manager &schema;
+        // Indexed by option, so each recognized option reaches its member without a lookup
+        std::vector<writer> fields;
+
+    public:
+        /**
+         * Create a binding. The schema must outlive the binding.
+         * @param schema the options to bind
+         */
+        explicit binding(const options_manager &schema) : schema(schema)
+        {
+        }
+
+        /**
+         * Bind an option to a member. Binding the same option again replaces the member it writes to.
+         * @param handle the handle returned by add_option or add_choice_option
+         * @param member the member to write, e.g. &config::level
+         * @return this binding, to chain calls
+         * @throws std::invalid_argument if the handle does not belong to the schema
+         * @throws std::logic_error if an enum member is bound to an option that is not a choice option, or a numeric member to an option without an argument
+         */
+        template<typename M>
+        binding &bind(const option_handle handle, M T::*member)
+        {
+            const std::vector<option *> &options = this->schema.get_options();
+            if (handle.index >= options.size())
+            {
+                throw std::invalid_argument("Binding refers to an option that does not exist.");
+            }
+            const option *opt = options[handle.index];
+            if constexpr (std::is_enum_v<M>)
+            {
+                if (opt->choices == nullptr)
+                {
+                    throw std::logic_error("Enum members can only be bound to choice options.");
+                }
+            } else if constexpr (std::is_arithmetic_v<M> && !std::is_same_v<M, bool>)
+            {
+                if (!opt->has_argument)
+                {
+                    throw std::logic_error("Numeric members can only be bound to options with an argument.");
+                }
+            }
+            std::string name = opt->long_name[0] ? "--" + std::string(opt->long_name) : "-" + std::string(opt->short_name);
+            if (this->fields.size() <= handle.index)
+            {
+                this->fields.resize(options.size());
+            }
+            this->fields[handle.index] = [member, name = std::move(name)](T &target, const char *argument, const int choice_value) {
+                detail::convert_argument(target.*member, argument, choice_value, name);
+            };
+            return *this;
+        }
+
+        /**
+         * Parse the command line arguments, writing the bound options into the target as they are recognized.
+         * Members of options that are not given keep their value, so the target can be initialized with the defaults.
+         * @param argc the number of arguments
+         * @param argv the arguments, the first one is the program name and is skipped
+         * @param target the struct to write to, it may be partially written if parsing fails
+         * @param result the result to fill, for operands and unbound options
+         * @throws parse_error if the arguments do not match the schema or a value cannot be converted
+         */
+        void parse(const int argc, char **argv, T &target, parse_result &result) const
+        {
+            target_sink sink(this->fields, target);
+            this->schema.parse_into(argc, argv, result, sink);
+        }
+
+        /**
+         * Parse the command line arguments, writing the bound options into the target as they are recognized.
+         * @param argc the number of arguments
+         * @param argv the arguments, the first one is the program name and is skipped
+         * @param target the struct to write to, it may be partially written if parsing fails
+         * @throws parse_error if the arguments do not match the schema or a value cannot be converted
+         */
+        void parse(const int argc, char **argv, T &target) const
+        {
+            parse_result result;
+            this->parse(argc, argv, target, result);
+        }
+    };
+}
+#endif
@@ -0,0 +1,108 @@
+#pragma once
+
+#ifndef CALLBACK_H
+#define CALLBACK_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace cclip
+{
+    template<typename Signature>
+    class callback;
+
+    /**
+     * A copyable wrapper for any function object, lambda or function pointer, like std::function.
+     * Handlers are stored as callbacks so the headers do not have to include <functional>, which is one of the most expensive standard headers to compile.
+     * @tparam R the return type
+     * @tparam Args the parameter types
+     */
+    template<typename R, typename... Args>
+    class callback<R(Args...)>
+    {
+    private:
+        void *target;
+        R (*invoke_target)(void *target, Args... args);
+        void *(*copy_target)(const void *target);
+        void (*destroy_target)(void *target);
+
+    public:
+        callback() noexcept : target(nullptr), invoke_target(nullptr), copy_target(nullptr), destroy_target(nullptr)
+        {
+        }
+
+        callback(std::nullptr_t) noexcept : callback()
+        {
+        }
+
+        template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, callback> && !std::is_member_pointer_v<std::decay_t<F> > && std::is_invocable_r_v<R, std::decay_t<F> &, Args...> > >
+        callback(F &&function) : callback()
+        {
+            using stored = std::decay_t<F>;
+            if constexpr (std::is_pointer_v<stored>)
+            {
+                if (function == nullptr)
+                {
+                    return;
+                }
+            }
+            this->target = new stored(std::forward<F>(function));
+            this->invoke_target = [](void *target, Args... args) -> R {
+                return static_cast<R>((*static_cast<stored *>(target))(std::forward<Args>(args)...));
+            };
+            this->copy_target = [](const void *target) -> void * {
+                return new stored(*static_cast<const stored *>(target));
+            };
+            this->destroy_target = [](void *target) {
+                delete static_cast<stored *>(target);
+            };
+        }
+
+        callback(const callback &other) : target(other.target == nullptr ? nullptr : other.copy_target(other.target)), invoke_target(other.invoke_target), copy_target(other.copy_target), destroy_target(other.destroy_target)
+        {
+        }
+
+        callback(callback &&other) noexcept : target(other.target), invoke_target(other.invoke_target), copy_target(other.copy_target), destroy_target(other.destroy_target)
+        {
+            other.target = nullptr;
+        }
+
+        callback &operator=(callback other) noexcept
+        {
+            std::swap(this->target, other.target);
+            std::swap(this->invoke_target, other.invoke_target);
+            std::swap(this->copy_target, other.copy_target);
+            std::swap(this->destroy_target, other.destroy_target);
+            return *this;
+        }
+
+        ~callback()
+        {
+            if (this->target != nullptr)
+            {
+                this->destroy_target(this->target);
+            }
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return this->target != nullptr;
+        }
+
+        /**
+         * Call the wrapped function.
+         * @throws std::logic_error if the callback is empty
+         */
+        R operator()(Args... args) const
+        {
+            if (this->target == nullptr)
+            {
+                throw std::logic_error("Called an empty callback.");
+            }
+            return this->invoke_target(this->target, std::forward<Args>(args)...);
+        }
+    };
+}
+#endif
@@ -0,0 +1,62 @@
+#pragma once
+
+#ifndef CANONICAL_H
+#define CANONICAL_H
+
+#include <cstdint>
+#include <vector>
+#include "config.h"
+#include "parse_result.h"
+
+namespace cclip
+{
+    struct hash128
+    {
+        std::uint64_t low;
+        std::uint64_t high;
+
+        bool operator==(const hash128 &other) const
+        {
+            return this->low == other.low && this->high == other.high;
+        }
+
+        bool operator!=(const hash128 &other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    /*
+     * The canonical form of a parse result identifies the options by index rather than by how they were spelled, and lists them in index order
+     * rather than in the order they were given, so "-f x -V" and "-V --file x" are the same. Operands keep their order, since it is usually meaningful.
+     * It is read straight from the presence bitset and the argument table of the result.
+     * Only the options that were given are part of it, default values are not: an option left at its default and the same value given explicitly differ.
+     * The hashes read bytes as little-endian, so they are the same on every platform.
+     */
+
+    /**
+     * Hash the canonical form of a parse result.
+     * @param result the parse result
+     * @param seed a seed, e.g. to tell the results of different tools apart
+     * @return the 64-bit hash
+     */
+    [[nodiscard]] std::uint64_t canonical_hash64(const parse_result &result, std::uint64_t seed = 0);
+
+    /**
+     * Hash the canonical form of a parse result.
+     * @param result the parse result
+     * @param seed a seed, e.g. to tell the results of different tools apart
+     * @return the 128-bit hash
+     */
+    [[nodiscard]] hash128 canonical_hash128(const parse_result &result, std::uint64_t seed = 0);
+
+    /**
+     * Serialize the canonical form of a parse result.
+     * The format is a version byte, the number of present options, then for each one its index and its value length plus one (0 for no value)
+     * followed by the value, then the number of operands and each operand's length followed by the operand. All integers are LEB128 varints.
+     * @param result the parse result
+     * @param out the buffer the serialized form is appended to
+     */
+    void serialize_canonical(const parse_result &result, std::vector<unsigned char> &out);
+}
+#endif
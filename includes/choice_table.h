@@ -0,0 +1,73 @@
+#pragma once
+
+#ifndef CHOICE_TABLE_H
+#define CHOICE_TABLE_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "config.h"
+
+namespace cclip
+{
+    struct choice
+    {
+        /**
+         * The value as it is typed on the command line (e.g. json).
+         */
+        const char *name;
+        /**
+         * The id the value maps to, usually an enum value.
+         */
+        int value;
+
+        template<typename T>
+        constexpr choice(const char *name, T value) : name(name), value(static_cast<int>(value))
+        {
+        }
+    };
+
+    /**
+     * A perfect-hash table of the values a choice option accepts.
+     * The table is built once when the option is added, so a lookup during parsing is one hash and one string compare.
+     */
+    class choice_table
+    {
+    private:
+        std::vector<choice> choices;
+        std::vector<std::int32_t> slots;
+        std::uint32_t seed;
+        std::uint32_t mask;
+
+        static std::uint32_t hash(std::string_view value, std::uint32_t seed);
+
+    public:
+        /**
+         * Build the table, searching for a seed that places every value in its own slot.
+         * @param choices the allowed values and the ids they map to
+         * @throws std::invalid_argument if the same value is listed twice
+         */
+        explicit choice_table(std::vector<choice> choices);
+
+        /**
+         * Find an allowed value.
+         * @param value the value given on the command line
+         * @return the matching choice, or nullptr if the value is not allowed
+         */
+        [[nodiscard]] const choice *find(const char *value) const;
+
+        /**
+         * Find an allowed value that is not NUL-terminated, e.g. a token in a line.
+         * @param value the value given on the command line
+         * @return the matching choice, or nullptr if the value is not allowed
+         */
+        [[nodiscard]] const choice *find(std::string_view value) const;
+
+        /**
+         * Get the allowed values in the order they were declared.
+         * @return the allowed values
+         */
+        [[nodiscard]] const std::vector<choice> &get_choices() const;
+    };
+}
+#endif
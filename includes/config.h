@@ -0,0 +1,20 @@
+#pragma once
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+/**
+ * When set to 1 (the default) every definition is compiled inline into each translation unit that includes cclip.hpp.
+ * Set it to 0 and link against the cclip_static target to compile the implementation only once.
+ */
+#ifndef CCLIP_HEADER_ONLY
+#define CCLIP_HEADER_ONLY 1
+#endif
+
+#if CCLIP_HEADER_ONLY
+#define CCLIP_INLINE inline
+#else
+#define CCLIP_INLINE
+#endif
+
+#endif
@@ -0,0 +1,131 @@
+#pragma once
+
+#ifndef CONFIG_RELOADER_H
+#define CONFIG_RELOADER_H
+
+#include <cstddef>
+#include <exception>
+#include <string>
+#include "callback.h"
+#include "config.h"
+#include "config_snapshot.h"
+
+namespace cclip
+{
+    class options_manager;
+
+    /**
+     * Keeps the latest valid snapshot of a config file and reloads it when the file changes.
+     * A reload parses the file off to the side and publishes it with a single atomic pointer swap, so readers never wait for it.
+     * Old snapshots are reclaimed once no reader holds them, which is tracked with hazard pointers.
+     */
+    class config_reloader
+    {
+    public:
+        /**
+         * The number of readers that can hold a snapshot at the same time, further readers spin until a slot frees up.
+         */
+        static constexpr size_t max_readers = 64;
+
+    private:
+        // The atomics, the lock and the watcher thread are defined in the source file, so this header does not need <atomic>, <mutex> or <thread>
+        struct hazard_slot;
+        struct shared_state;
+
+        const options_manager &schema;
+        std::string path;
+        shared_state *state;
+
+        void watch();
+
+        void reclaim();
+
+        void report(const std::exception &error) const;
+
+    public:
+        /**
+         * Keeps a snapshot alive while it is being read.
+         * Readers should hold it briefly (e.g. for one request) and read again to see newer snapshots.
+         */
+        class reader
+        {
+        private:
+            hazard_slot *slot;
+            const config_snapshot *snapshot;
+
+            friend class config_reloader;
+
+            reader(hazard_slot *slot, const config_snapshot *snapshot);
+
+        public:
+            reader(reader &&other) noexcept;
+
+            reader(const reader &) = delete;
+
+            reader &operator=(const reader &) = delete;
+
+            reader &operator=(reader &&) = delete;
+
+            ~reader();
+
+            const config_snapshot *operator->() const
+            {
+                return this->snapshot;
+            }
+
+            const config_snapshot &operator*() const
+            {
+                return *this->snapshot;
+            }
+        };
+
+        /**
+         * Load the config file. The schema must outlive the reloader.
+         * @param schema the options the file may contain
+         * @param path the path of the config file
+         * @throws parse_error if the file does not match the schema
+         * @throws std::runtime_error if the file cannot be read
+         */
+        config_reloader(const options_manager &schema, std::string path);
+
+        config_reloader(const config_reloader &) = delete;
+
+        config_reloader &operator=(const config_reloader &) = delete;
+
+        /**
+         * Stops watching and frees every snapshot, no reader may be alive at this point.
+         */
+        ~config_reloader();
+
+        /**
+         * Start watching the config file on a background thread, reloading it whenever it is written.
+         * This uses inotify on Linux and polls the modification time elsewhere.
+         */
+        void start();
+
+        /**
+         * Stop watching the config file.
+         */
+        void stop();
+
+        /**
+         * Reload the config file now.
+         * If the file is missing or invalid the current snapshot is kept and the error is reported.
+         * @return whether or not a new snapshot was published
+         */
+        bool reload();
+
+        /**
+         * Get the current snapshot. This never blocks on a reload.
+         * @return a reader that keeps the snapshot alive until it is destroyed
+         */
+        [[nodiscard]] reader read() const;
+
+        /**
+         * Set the function that is called when a reload fails, instead of printing the error to stderr.
+         * @param handler the function to call with the error
+         */
+        void on_error(callback<void(const std::exception &)> handler);
+    };
+}
+#endif
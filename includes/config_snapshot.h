@@ -0,0 +1,86 @@
+#pragma once
+
+#ifndef CONFIG_SNAPSHOT_H
+#define CONFIG_SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include "config.h"
+#include "option_handle.h"
+#include "parse_result.h"
+
+namespace cclip
+{
+    class options_manager;
+
+    /**
+     * An immutable set of options read from a config file.
+     * Each non-empty line of the file is either a bare option name (for flags) or "name = value", where name is the short or long name minus the dashes.
+     * Lines starting with # are comments.
+     */
+    class config_snapshot
+    {
+    private:
+        std::string buffer;
+        std::vector<char *> args;
+        parse_result result;
+
+    public:
+        /**
+         * Read and validate a config file. Only the option names and values are checked: required options, positional arguments and
+         * constraints are left to the command line.
+         * @param schema the options the file may contain
+         * @param path the path of the config file
+         * @throws parse_error if the file does not match the schema, including a line without a name, a bare name for an option that takes
+         * a value or a value for a flag
+         * @throws std::runtime_error if the file cannot be read
+         */
+        config_snapshot(const options_manager &schema, const std::string &path);
+
+        // The parse result points into buffer, so a snapshot stays where it was built
+        config_snapshot(const config_snapshot &) = delete;
+
+        config_snapshot &operator=(const config_snapshot &) = delete;
+
+        /**
+         * Check if the option is set in the config file.
+         * @param handle the handle returned by add_option
+         * @return whether or not the option is set
+         */
+        [[nodiscard]] bool is_present(const option_handle handle) const
+        {
+            return this->result.is_present(handle);
+        }
+
+        /**
+         * Get the value of the option.
+         * @param handle the handle returned by add_option
+         * @return the value, or nullptr if the option is not set or has no argument
+         */
+        [[nodiscard]] const char *get(const option_handle handle) const
+        {
+            return this->result.get(handle);
+        }
+
+        /**
+         * Get the id of the value given to a choice option.
+         * @tparam T the enum or integer type the ids were declared with
+         * @param handle the handle returned by add_choice_option
+         * @param fallback the value to return if the option is not set
+         * @return the id of the value, or the fallback
+         */
+        template<typename T = int>
+        [[nodiscard]] T get_choice(const option_handle handle, T fallback = T{}) const
+        {
+            const int value = this->result.get_choice_value(handle);
+            return value == -1 ? fallback : static_cast<T>(value);
+        }
+
+        /**
+         * Get the parsed options.
+         * @return the parse result
+         */
+        [[nodiscard]] const parse_result &get_result() const;
+    };
+}
+#endif
@@ -0,0 +1,59 @@
+#pragma once
+
+#ifndef CONSTRAINT_SET_H
+#define CONSTRAINT_SET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "config.h"
+
+namespace cclip
+{
+    /**
+     * Rules between options, such as "--out requires --format" or "exactly one of --a, --b, --c", compiled into bitmasks over option indices.
+     * Every rule has the same shape: when all of its trigger options are present, the number of its group options that are present must be within a range.
+     * The masks of all rules are stored back to back, so checking them is one pass of ANDs and popcounts over the presence bitset.
+     */
+    class constraint_set
+    {
+    private:
+        struct rule
+        {
+            size_t offset;
+            size_t words;
+            std::uint32_t min_count;
+            std::uint32_t max_count;
+            std::string message;
+        };
+
+        std::vector<std::uint64_t> masks;
+        std::vector<rule> rules;
+
+    public:
+        /**
+         * Add a rule.
+         * @param trigger the indices of the options that must all be present for the rule to apply, none to always apply it
+         * @param group the indices of the options that are counted
+         * @param min_count the minimum number of group options that must be present
+         * @param max_count the maximum number of group options that may be present
+         * @param message the error to report when the rule is violated
+         */
+        void add(const std::vector<std::uint32_t> &trigger, const std::vector<std::uint32_t> &group, std::uint32_t min_count, std::uint32_t max_count, std::string message);
+
+        /**
+         * Check every rule against a presence bitset.
+         * @param presence bit i of word i / 64 is set if the option with index i is present
+         * @param errors the message of every violated rule is appended to it, one per line
+         * @return false if any rule is violated
+         */
+        bool check(const std::vector<std::uint64_t> &presence, std::string &errors) const;
+
+        [[nodiscard]] bool empty() const
+        {
+            return this->rules.empty();
+        }
+    };
+}
+#endif
@@ -0,0 +1,72 @@
+#pragma once
+
+#ifndef DEFAULT_VALUE_H
+#define DEFAULT_VALUE_H
+
+#include <string>
+#include "callback.h"
+#include "config.h"
+
+namespace cclip
+{
+    /**
+     * The value an option falls back to when it is not given, either fixed or computed.
+     * A computed value is only computed the first time it is needed, and at most once even if it is needed from several threads at the same time.
+     */
+    class default_value
+    {
+    private:
+        const char *value;
+        callback<std::string()> compute;
+        const char *label;
+        int choice_value;
+        // The once_flag lives in the source file, so this header does not need <mutex>
+        struct lazy_state;
+        lazy_state *state;
+        mutable std::string computed;
+
+    public:
+        /**
+         * A fixed default value.
+         * @param value the value, it is also shown in the help
+         * @param choice_value the id the value maps to if the option is a choice option, otherwise -1
+         */
+        explicit default_value(const char *value, int choice_value = -1);
+
+        /**
+         * A computed default value.
+         * @param compute the function computing the value, called at most once
+         * @param label the text shown for the value in the help (e.g. number of CPUs), or nullptr to not show it
+         */
+        default_value(callback<std::string()> compute, const char *label);
+
+        default_value(const default_value &) = delete;
+
+        default_value &operator=(const default_value &) = delete;
+
+        ~default_value();
+
+        /**
+         * Get the value, computing it on the first call.
+         * @return the value, valid as long as the default_value
+         * @throws anything the compute function throws, in which case the next call tries again
+         */
+        [[nodiscard]] const char *get() const;
+
+        /**
+         * Get the text to show in the help, without computing the value.
+         * @return the fixed value, the label of a computed value, or nullptr
+         */
+        [[nodiscard]] const char *get_label() const;
+
+        /**
+         * Get the id the fixed value maps to.
+         * @return the id, or -1 if the option is not a choice option or the value is computed
+         */
+        [[nodiscard]] int get_choice_value() const
+        {
+            return this->choice_value;
+        }
+    };
+}
+#endif
@@ -0,0 +1,349 @@
+#pragma once
+
+#ifndef EVENT_STREAM_H
+#define EVENT_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include "config.h"
+#include "option_handle.h"
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#include <exception>
+#define CCLIP_HAS_COROUTINES 1
+#endif
+#endif
+
+namespace cclip
+{
+    class options_manager;
+
+    enum class event_kind
+    {
+        /**
+         * An option was recognized, with its argument if it takes one.
+         */
+        option,
+        /**
+         * An argument that is not an option or an option argument.
+         */
+        operand,
+        /**
+         * An argument that does not match the schema, see parse_event::error.
+         */
+        error
+    };
+
+    enum class event_error
+    {
+        none,
+        /**
+         * The argument looks like an option but no option has that name.
+         */
+        unknown_option,
+        /**
+         * The option takes an argument but it was the last one.
+         */
+        missing_argument,
+        /**
+         * The argument of a choice option is not one of its values.
+         */
+        invalid_value,
+        /**
+         * An operand or option argument is not valid UTF-8, only reported if the schema validates UTF-8.
+         */
+        invalid_utf8
+    };
+
+    /**
+     * One event of a pull parse. The views point into argv.
+     */
+    struct parse_event
+    {
+        event_kind kind = event_kind::operand;
+        event_error error = event_error::none;
+        /**
+         * The option, for option events, for missing_argument and invalid_value errors, and for invalid_utf8 errors in an option argument.
+         */
+        option_handle option{0};
+        /**
+         * The option as it was written (e.g. --format), for option and error events, empty for an invalid_utf8 error in an operand.
+         */
+        std::string_view name;
+        /**
+         * The argument of the option, the operand, or the rejected value of an invalid_value or invalid_utf8 error.
+         */
+        std::string_view value;
+        /**
+         * The id of the value of a choice option, or -1.
+         */
+        int choice_value = -1;
+    };
+
+    /**
+     * Parses arguments one event at a time, in the order they were given, instead of filling a parse_result.
+     * This is useful to apply options to something as they arrive. Nothing is allocated and argv is not modified.
+     * Unlike parse, errors are reported as events and parsing goes on after them, and required options and positional arguments are not checked.
+     */
+    class event_stream
+    {
+    public:
+        class iterator
+        {
+        private:
+            event_stream *stream;
+            parse_event event;
+
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = parse_event;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const parse_event *;
+            using reference = const parse_event &;
+
+            iterator() : stream(nullptr)
+            {
+            }
+
+            explicit iterator(event_stream *stream) : stream(stream)
+            {
+                ++*this;
+            }
+
+            reference operator*() const
+            {
+                return this->event;
+            }
+
+            pointer operator->() const
+            {
+                return &this->event;
+            }
+
+            iterator &operator++()
+            {
+                if (!this->stream->next(this->event))
+                {
+                    this->stream = nullptr;
+                }
+                return *this;
+            }
+
+            bool operator==(const iterator &other) const
+            {
+                return this->stream == other.stream;
+            }
+
+            bool operator!=(const iterator &other) const
+            {
+                return this->stream != other.stream;
+            }
+        };
+
+    private:
+        const options_manager &schema;
+        int argc;
+        const char *const *argv;
+        int position;
+        bool terminated;
+
+    public:
+        /**
+         * Create a stream over the arguments. The schema and argv must outlive the stream.
+         * @param schema the options the arguments may contain
+         * @param argc the number of arguments
+         * @param argv the arguments, the first one is the program name and is skipped
+         */
+        event_stream(const options_manager &schema, int argc, const char *const *argv);
+
+        /**
+         * Parse the next event.
+         * @param event set to the event
+         * @return false once every argument was parsed
+         */
+        bool next(parse_event &event);
+
+        iterator begin()
+        {
+            return iterator(this);
+        }
+
+        iterator end()
+        {
+            return iterator();
+        }
+    };
+
+    /**
+     * Parse arguments one event at a time, see event_stream.
+     * @param schema the options the arguments may contain
+     * @param argc the number of arguments
+     * @param argv the arguments, the first one is the program name and is skipped
+     * @return the events, to iterate with a range-based for loop
+     */
+    event_stream events(const options_manager &schema, int argc, const char *const *argv);
+
+#ifdef CCLIP_HAS_COROUTINES
+    /**
+     * A C++20 generator of parse events, see generate_events.
+     */
+    class event_generator
+    {
+    public:
+        struct promise_type
+        {
+            const parse_event *current = nullptr;
+            std::exception_ptr exception;
+
+            event_generator get_return_object()
+            {
+                return event_generator(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            std::suspend_always initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            std::suspend_always final_suspend() noexcept
+            {
+                return {};
+            }
+
+            std::suspend_always yield_value(const parse_event &event) noexcept
+            {
+                this->current = &event;
+                return {};
+            }
+
+            void return_void() noexcept
+            {
+            }
+
+            void unhandled_exception()
+            {
+                this->exception = std::current_exception();
+            }
+        };
+
+        class iterator
+        {
+        private:
+            std::coroutine_handle<promise_type> coroutine;
+
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = parse_event;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const parse_event *;
+            using reference = const parse_event &;
+
+            iterator() = default;
+
+            explicit iterator(const std::coroutine_handle<promise_type> coroutine) : coroutine(coroutine)
+            {
+                ++*this;
+            }
+
+            reference operator*() const
+            {
+                return *this->coroutine.promise().current;
+            }
+
+            pointer operator->() const
+            {
+                return this->coroutine.promise().current;
+            }
+
+            iterator &operator++()
+            {
+                this->coroutine.resume();
+                if (this->coroutine.done())
+                {
+                    const std::exception_ptr exception = this->coroutine.promise().exception;
+                    this->coroutine = nullptr;
+                    if (exception)
+                    {
+                        std::rethrow_exception(exception);
+                    }
+                }
+                return *this;
+            }
+
+            bool operator==(const iterator &other) const
+            {
+                return this->coroutine == other.coroutine;
+            }
+
+            bool operator!=(const iterator &other) const
+            {
+                return this->coroutine != other.coroutine;
+            }
+        };
+
+    private:
+        std::coroutine_handle<promise_type> coroutine;
+
+        explicit event_generator(const std::coroutine_handle<promise_type> coroutine) : coroutine(coroutine)
+        {
+        }
+
+    public:
+        event_generator(event_generator &&other) noexcept : coroutine(other.coroutine)
+        {
+            other.coroutine = nullptr;
+        }
+
+        event_generator(const event_generator &) = delete;
+
+        event_generator &operator=(const event_generator &) = delete;
+
+        event_generator &operator=(event_generator &&) = delete;
+
+        ~event_generator()
+        {
+            if (this->coroutine)
+            {
+                this->coroutine.destroy();
+            }
+        }
+
+        /**
+         * Start the generator, it can only be iterated once.
+         */
+        iterator begin()
+        {
+            return iterator(this->coroutine);
+        }
+
+        iterator end()
+        {
+            return iterator();
+        }
+    };
+
+    /**
+     * Parse arguments one event at a time as a C++20 generator, see event_stream.
+     * The events are produced lazily as the generator is resumed, and each one is only valid until the next.
+     * @param schema the options the arguments may contain
+     * @param argc the number of arguments
+     * @param argv the arguments, the first one is the program name and is skipped
+     * @return the generator
+     */
+    // Defined here rather than in the source file, so it does not depend on the language level the compiled library was built with
+    inline event_generator generate_events(const options_manager &schema, const int argc, const char *const *argv)
+    {
+        event_stream stream(schema, argc, argv);
+        parse_event event;
+        while (stream.next(event))
+        {
+            co_yield event;
+        }
+    }
+#endif
+}
+#endif
@@ -0,0 +1,195 @@
+#pragma once
+
+#ifndef INCREMENTAL_PARSER_H
+#define INCREMENTAL_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "option_handle.h"
+
+namespace cclip
+{
+    class options_manager;
+
+    /**
+     * Parses a command line as it is being typed, e.g. to show validation hints in an interactive console.
+     * The tokens and their classification are kept between edits, and an edit only re-tokenizes the text it touched and
+     * re-classifies tokens until the classification matches the previous one again. The tokens live in a gap buffer at the last edit,
+     * so typing does not shift or move the tokens after the cursor.
+     * Tokens are separated by whitespace.
+     */
+    class incremental_parser
+    {
+    public:
+        enum class token_kind
+        {
+            /**
+             * A token that is neither an option nor an argument.
+             */
+            operand,
+            /**
+             * The -- argument, every token after it is a literal.
+             */
+            terminator,
+            /**
+             * An operand after the -- argument, even if it starts with a dash.
+             */
+            literal,
+            /**
+             * A known option.
+             */
+            option,
+            /**
+             * The argument of the option before it.
+             */
+            argument,
+            /**
+             * An option that is not in the schema.
+             */
+            unknown_option,
+            /**
+             * An option that takes an argument but is the last token.
+             */
+            missing_argument,
+            /**
+             * An argument that is not one of the values its choice option accepts.
+             */
+            invalid_value,
+            /**
+             * An operand or argument that is not valid UTF-8, only if the schema validates UTF-8.
+             */
+            invalid_utf8,
+            /**
+             * A literal that is not valid UTF-8, only if the schema validates UTF-8.
+             */
+            invalid_utf8_literal
+        };
+
+        struct token
+        {
+            /**
+             * The offset of the token in the line.
+             */
+            size_t begin;
+            /**
+             * The length of the token in bytes.
+             */
+            size_t length;
+            token_kind kind;
+            /**
+             * The index of the option the token is or belongs to, or -1.
+             */
+            std::int32_t option;
+        };
+
+    private:
+        const options_manager &schema;
+        std::string line;
+        /**
+         * The tokens with a gap of unused entries at the last edit. Tokens in front of the gap store their offset from the start of the line,
+         * tokens behind it their offset from the end, so an edit does not change the tokens behind it.
+         */
+        std::vector<token> tokens;
+        size_t gap_begin;
+        size_t gap_end;
+        std::vector<std::uint32_t> counts;
+        /**
+         * One bit per option that appears in the line, kept in sync with counts so the schema's constraints can be checked.
+         */
+        std::vector<std::uint64_t> presence;
+        size_t error_count;
+        size_t missing_required;
+        size_t before_requires_present;
+        size_t operand_count;
+        size_t min_operands;
+        size_t max_operands;
+
+        [[nodiscard]] token &stored(size_t index);
+
+        [[nodiscard]] size_t begin_of(size_t index) const;
+
+        void move_gap(size_t index);
+
+        void tokenize(size_t begin, size_t end, std::vector<token> &out) const;
+
+        [[nodiscard]] token_kind classify(size_t index, std::int32_t &option) const;
+
+        void count(const token &t, int direction);
+
+    public:
+        /**
+         * Create a parser for an empty line. The schema must outlive the parser.
+         * @param schema the options the line may contain
+         */
+        explicit incremental_parser(const options_manager &schema);
+
+        /**
+         * Replace the whole line and parse it from scratch.
+         * @param line the new line
+         */
+        void set_line(const std::string &line);
+
+        /**
+         * Apply an edit to the line and update the parse state.
+         * @param offset the offset in the line where the edit starts
+         * @param erase_count the number of bytes removed at the offset
+         * @param insert the text inserted at the offset
+         */
+        void edit(size_t offset, size_t erase_count, const std::string &insert);
+
+        /**
+         * Get the current line.
+         * @return the line
+         */
+        [[nodiscard]] const std::string &get_line() const;
+
+        /**
+         * Get the number of tokens in the line.
+         * @return the number of tokens
+         */
+        [[nodiscard]] size_t get_token_count() const;
+
+        /**
+         * Get a token of the line.
+         * @param index the index of the token, less than get_token_count
+         * @return the token
+         */
+        [[nodiscard]] token get_token(size_t index) const;
+
+        /**
+         * Get a copy of the tokens of the line in order.
+         * @return the tokens
+         */
+        [[nodiscard]] std::vector<token> get_tokens() const;
+
+        /**
+         * Get a message describing a token error, in the same wording as parse.
+         * @param t the token
+         * @return the message, or an empty string if the token is valid
+         */
+        [[nodiscard]] std::string describe(const token &t) const;
+
+        /**
+         * Get the number of tokens with an error.
+         * @return the number of errors
+         */
+        [[nodiscard]] size_t get_error_count() const;
+
+        /**
+         * Check if the option appears in the line.
+         * @param handle the handle returned by add_option
+         * @return whether or not the option is present
+         */
+        [[nodiscard]] bool is_present(option_handle handle) const;
+
+        /**
+         * Check if the line would parse without errors, including required options and the schema's constraints.
+         * @return whether or not the line is valid
+         */
+        [[nodiscard]] bool is_valid() const;
+    };
+}
+#endif
@@ -0,0 +1,51 @@
+#pragma once
+
+#ifndef NAME_TABLE_H
+#define NAME_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "config.h"
+
+namespace cclip
+{
+    /**
+     * Maps option names to option indices, with open addressing over one flat array of slots.
+     * A lookup is one hash and usually one string compare, and the table only needs the headers the rest of cclip already uses.
+     */
+    class name_table
+    {
+    private:
+        struct slot
+        {
+            std::string_view name;
+            std::uint32_t index;
+        };
+
+        std::vector<slot> slots;
+        size_t count = 0;
+
+        static std::uint32_t hash(std::string_view name);
+
+        void grow();
+
+    public:
+        /**
+         * Add a name. The characters are not copied, they must outlive the table.
+         * @param name the name, it must not be empty
+         * @param index the index of the option
+         * @return false if the name was already added, in which case it keeps its index
+         */
+        bool insert(std::string_view name, std::uint32_t index);
+
+        /**
+         * Find a name.
+         * @param name the name
+         * @return the index of the option, or -1 if there is no option with that name
+         */
+        [[nodiscard]] std::int32_t find(std::string_view name) const;
+    };
+}
+#endif
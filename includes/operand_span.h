@@ -0,0 +1,65 @@
+#pragma once
+
+#ifndef OPERAND_SPAN_H
+#define OPERAND_SPAN_H
+
+#include <cstddef>
+
+namespace cclip
+{
+    /**
+     * A view of the operands (the arguments that are not options) of a parse.
+     * It points into the argv that was parsed, so the operands are never copied; parse moves them to the front of argv, right after the program name.
+     */
+    class operand_span
+    {
+    private:
+        char **first;
+        size_t count;
+
+    public:
+        constexpr operand_span() : first(nullptr), count(0)
+        {
+        }
+
+        constexpr operand_span(char **first, const size_t count) : first(first), count(count)
+        {
+        }
+
+        [[nodiscard]] constexpr char *const *begin() const
+        {
+            return this->first;
+        }
+
+        [[nodiscard]] constexpr char *const *end() const
+        {
+            return this->first + this->count;
+        }
+
+        [[nodiscard]] constexpr size_t size() const
+        {
+            return this->count;
+        }
+
+        [[nodiscard]] constexpr bool empty() const
+        {
+            return this->count == 0;
+        }
+
+        [[nodiscard]] constexpr const char *operator[](const size_t index) const
+        {
+            return this->first[index];
+        }
+
+        /**
+         * Get the operands from an offset onwards.
+         * @param offset the number of operands to skip
+         * @return the remaining operands, or an empty span if there are not that many
+         */
+        [[nodiscard]] constexpr operand_span subspan(const size_t offset) const
+        {
+            return offset >= this->count ? operand_span(this->first + this->count, 0) : operand_span(this->first + offset, this->count - offset);
+        }
+    };
+}
+#endif
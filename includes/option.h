@@ -3,8 +3,13 @@
 #ifndef OPTION_H
 #define OPTION_H
 
+#include <cstdint>
+
 namespace cclip
 {
+    class choice_table;
+    class default_value;
+
     struct option
     {
         /**
@@ -37,6 +42,22 @@ namespace cclip
          * The argument of the option.
          */
         char *argument;
+        /**
+         * The values the argument is restricted to, or nullptr if any value is accepted.
+         */
+        const choice_table *choices = nullptr;
+        /**
+         * The value used when the option is not given, or nullptr if there is none.
+         */
+        const default_value *defaults = nullptr;
+        /**
+         * The id of the choice the argument matched, or -1 if the option is not a choice option or was not given.
+         */
+        int choice_value = -1;
+        /**
+         * The position of the option in the schema, this is the index an option_handle refers to.
+         */
+        std::uint32_t index = 0;
     };
 }
 #endif
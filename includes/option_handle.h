@@ -0,0 +1,38 @@
+#pragma once
+
+#ifndef OPTION_HANDLE_H
+#define OPTION_HANDLE_H
+
+#include <cstdint>
+
+namespace cclip
+{
+    /**
+     * A reference to an option returned by options_manager::add_option.
+     * It is the position of the option in the schema, so looking an option up by handle is an array index instead of a string search.
+     */
+    struct option_handle
+    {
+        std::uint32_t index;
+
+        bool operator==(const option_handle &other) const
+        {
+            return this->index == other.index;
+        }
+
+        bool operator!=(const option_handle &other) const
+        {
+            return this->index != other.index;
+        }
+    };
+
+    /**
+     * A reference to a named positional argument returned by options_manager::add_positional.
+     * It is the position of the operand it refers to.
+     */
+    struct positional_handle
+    {
+        std::uint32_t index;
+    };
+}
+#endif
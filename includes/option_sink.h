@@ -0,0 +1,28 @@
+#pragma once
+
+#ifndef OPTION_SINK_H
+#define OPTION_SINK_H
+
+#include "option_handle.h"
+
+namespace cclip
+{
+    /**
+     * Receives the options as parse_into recognizes them, in the order they were given, see binding.
+     */
+    class option_sink
+    {
+    public:
+        virtual ~option_sink() = default;
+
+        /**
+         * Called once for every option in the arguments.
+         * @param handle the option
+         * @param argument the argument of the option, or nullptr if it has none
+         * @param choice_value the id of the value of a choice option, or -1
+         * @throws parse_error to reject the value, which fails the parse
+         */
+        virtual void accept(option_handle handle, const char *argument, int choice_value) = 0;
+    };
+}
+#endif
@@ -1,11 +1,26 @@
 #pragma once
 
-#include <algorithm>
-#include <cstring>
+#include <initializer_list>
+#include <iosfwd>
+#include <cstdint>
+#include <string>
+#include <string_view>
 #include <vector>
-#include <iostream>
-#include <sstream>
+#include "callback.h"
+#include "choice_table.h"
+#include "config.h"
+#include "constraint_set.h"
+#include "default_value.h"
+#include "operand_span.h"
+#include "name_table.h"
 #include "option.h"
+#include "option_handle.h"
+#include "option_sink.h"
+#include "parse_error.h"
+#include "parse_result.h"
+#include "positional.h"
+#include "suggestion_index.h"
+#include "utf8.h"
 
 namespace cclip
 {
@@ -14,13 +29,57 @@ namespace cclip
     private:
         const char *context;
         std::vector<option *> options;
-        std::vector<option *> present_options;
+        std::vector<positional> positionals;
+        parse_result result;
+        std::vector<callback<void(const char *argument)> > handlers;
+        name_table names;
+        suggestion_index suggestions;
+        constraint_set constraints;
+        size_t parallel_threshold;
         std::vector<const char *> example_usages;
         const char *version;
         const char *description;
         std::string command_name;
+        bool utf8_validation;
+        size_t help_width;
+        std::vector<size_t> option_label_widths;
+        std::vector<size_t> positional_label_widths;
+        size_t label_column;
 
-        option *get_option_from_global_list(const std::string &name);
+        [[nodiscard]] option *get_option_from_global_list(const std::string &name) const;
+
+        void store_argument(const option *opt, const char *name, char *argument, parse_result &result) const;
+
+        /**
+         * The parse loop shared by parse, parse_into and config files.
+         * @param complete whether or not to also check required options, positional arguments and constraints; a config file only gives
+         * some of the options, so only its names and values are checked
+         */
+        bool parse_arguments(int argc, char **argv, parse_result &result, bool dispatch, option_sink *sink, bool complete) const;
+
+        [[nodiscard]] std::int32_t classify(const char *arg) const;
+
+        [[nodiscard]] std::vector<std::int32_t> classify_parallel(int argc, char **argv) const;
+
+        [[nodiscard]] static std::string help_label(const option &opt);
+
+        [[nodiscard]] static std::string help_label(const positional &slot);
+
+        void measure_option(std::uint32_t index);
+
+        void measure_positionals();
+
+        static void align_help_column(std::ostream &out, size_t &cursor, size_t column, size_t indent);
+
+        static void append_wrapped(std::ostream &out, std::string_view text, size_t &cursor, size_t indent, size_t width);
+
+        [[nodiscard]] static size_t terminal_width();
+
+        [[nodiscard]] std::string display_names(std::initializer_list<option_handle> handles) const;
+
+        friend class config_snapshot;
+        friend class event_stream;
+        friend class incremental_parser;
 
     public:
         /**
@@ -31,6 +90,16 @@ namespace cclip
          */
         explicit options_manager(const char *context, const char *description = nullptr);
 
+        // Options, choice tables and default values are owned through raw pointers, so an options_manager cannot be copied
+        options_manager(const options_manager &) = delete;
+
+        options_manager &operator=(const options_manager &) = delete;
+
+        /**
+         * Frees every option along with its choices and default value.
+         */
+        ~options_manager();
+
         /**
          * Add an example usage to the options manager.
          * @param example_usage the example usage to add
@@ -76,16 +145,193 @@ namespace cclip
          * @param is_required whether or not the option is required
          * @param has_argument whether or not the option has an argument
          * @param executes_before_requires  Whether or not the option executes before it requires any other options. This means that if required options are not present but this is, the missing required options will be ignored. This is great for help and version options.
-         * @return the option that was added
+         * @return a handle to the option that was added
+         */
+        option_handle add_option(const char *short_name, const char *long_name, const char *description, bool is_required, bool has_argument, bool executes_before_requires = false);
+
+        /**
+         * Add an option whose argument must be one of a fixed set of values.
+         * The value is validated while parsing and mapped to the id given for it, so it can be switched on instead of compared as a string.
+         * @param short_name the short name of the option (e.g. -f) minus the dash (-)
+         * @param long_name the long name of the option (e.g. --format) minus the dashes (--)
+         * @param description the description of the option
+         * @param is_required whether or not the option is required
+         * @param choices the allowed values and the ids they map to (e.g. {{"json", format::json}, {"xml", format::xml}})
+         * @return a handle to the option that was added
+         */
+        option_handle add_choice_option(const char *short_name, const char *long_name, const char *description, bool is_required, std::initializer_list<choice> choices);
+
+        /**
+         * Add an option whose argument must be one of a fixed set of values.
+         * Each value maps to its position in the list.
+         * @param short_name the short name of the option (e.g. -f) minus the dash (-)
+         * @param long_name the long name of the option (e.g. --format) minus the dashes (--)
+         * @param description the description of the option
+         * @param is_required whether or not the option is required
+         * @param choices the allowed values
+         * @return a handle to the option that was added
+         */
+        option_handle add_choice_option(const char *short_name, const char *long_name, const char *description, bool is_required, std::initializer_list<const char *> choices);
+
+        /**
+         * Add an option whose argument must be one of a fixed set of values, built at runtime.
+         * @param short_name the short name of the option (e.g. -f) minus the dash (-)
+         * @param long_name the long name of the option (e.g. --format) minus the dashes (--)
+         * @param description the description of the option
+         * @param is_required whether or not the option is required
+         * @param choices the allowed values and the ids they map to
+         * @return a handle to the option that was added
+         */
+        option_handle add_choice_option(const char *short_name, const char *long_name, const char *description, bool is_required, std::vector<choice> choices);
+
+        /**
+         * Add a named positional argument. Positional arguments take the operands (the arguments that are not options) in the order they were added.
+         * @param name the name of the argument as it is shown in the help (e.g. source)
+         * @param description the description of the argument
+         * @param is_required whether or not the argument is required
+         * @return a handle to the argument that was added
+         * @throws std::logic_error if the variadic argument was already set
+         */
+        positional_handle add_positional(const char *name, const char *description, bool is_required = true);
+
+        /**
+         * Set the variadic argument, which takes every operand after the named positional arguments.
+         * If positional arguments are added but no variadic argument is set, extra operands are an error.
+         * @param name the name of the argument as it is shown in the help (e.g. files)
+         * @param description the description of the argument
+         * @param is_required whether or not at least one operand is required
+         */
+        void set_variadic(const char *name, const char *description, bool is_required = false);
+
+        /**
+         * Set the value an option falls back to when it is not given, see get_or_default. It is shown in the help.
+         * @param handle the handle returned by add_option or add_choice_option
+         * @param value the value, for a choice option one of its values
+         * @throws std::invalid_argument if the handle does not belong to this options_manager, the value is null or not one of the choices
+         * @throws std::logic_error if the option has no argument
+         */
+        void set_default(option_handle handle, const char *value);
+
+        /**
+         * Set a computed value an option falls back to when it is not given, see get_or_default.
+         * It is only computed the first time it is needed, e.g. to not probe the system when the option is given. The help shows the label instead of computing it.
+         * @param handle the handle returned by add_option
+         * @param compute the function computing the value, called at most once
+         * @param label the text shown for the value in the help (e.g. number of CPUs), or nullptr to not show it
+         * @throws std::invalid_argument if the handle does not belong to this options_manager or compute is empty
+         * @throws std::logic_error if the option has no argument or is a choice option, whose default must be one of its values
+         */
+        void set_default(option_handle handle, callback<std::string()> compute, const char *label);
+
+        /**
+         * Require other options whenever an option is present, e.g. --out requires --format.
+         * Like required options, constraints are not checked if an option that executes before requires is present.
+         * @param handle the option
+         * @param required the options that must be present with it
+         * @throws std::invalid_argument if a handle does not belong to this options_manager
          */
-        option *add_option(const char *short_name, const char *long_name, const char *description, bool is_required, bool has_argument, bool executes_before_requires = false);
+        void add_requires(option_handle handle, std::initializer_list<option_handle> required);
+
+        /**
+         * Forbid other options whenever an option is present, e.g. --json conflicts with --table.
+         * @param handle the option
+         * @param conflicting the options that must not be present with it
+         * @throws std::invalid_argument if a handle does not belong to this options_manager
+         */
+        void add_conflicts(option_handle handle, std::initializer_list<option_handle> conflicting);
+
+        /**
+         * Require exactly one option of a group.
+         * @param group the options
+         * @throws std::invalid_argument if a handle does not belong to this options_manager
+         */
+        void add_one_of(std::initializer_list<option_handle> group);
+
+        /**
+         * Require at least one option of a group.
+         * @param group the options
+         * @throws std::invalid_argument if a handle does not belong to this options_manager
+         */
+        void add_any_of(std::initializer_list<option_handle> group);
+
+        /**
+         * Allow at most one option of a group, the options are mutually exclusive.
+         * @param group the options
+         * @throws std::invalid_argument if a handle does not belong to this options_manager
+         */
+        void add_at_most_one_of(std::initializer_list<option_handle> group);
+
+        /**
+         * Bind a handler to an option. During parse the handler is called as soon as the option is recognized, with its argument (or nullptr),
+         * so the options do not have to be checked one by one afterwards.
+         * If the option executes before requires (e.g. --help), parse stops right after calling its handler.
+         * @param handle the handle returned by add_option
+         * @param handler the function to call
+         * @throws std::invalid_argument if the handle does not belong to this options_manager
+         */
+        void on(option_handle handle, callback<void(const char *argument)> handler);
+
+        /**
+         * Bind a member setter to an option, see on(option_handle, callback).
+         * @param handle the handle returned by add_option
+         * @param target the object to call the setter on, it must outlive the options_manager
+         * @param setter the member function to call with the argument (or nullptr)
+         * @throws std::invalid_argument if the handle does not belong to this options_manager
+         */
+        template<typename T>
+        void on(const option_handle handle, T &target, void (T::*setter)(const char *argument))
+        {
+            this->on(handle, [&target, setter](const char *argument) { (target.*setter)(argument); });
+        }
 
         /**
          * Parse the command line arguments.
+         * Handlers bound with on() are called in the order the options appear. If parsing fails after a handler ran, the error is still printed and the program exits.
          * @param argc the number of arguments
          * @param argv the arguments
+         * @return false if the handler of an option that executes before requires stopped the parse early, true otherwise
          */
-        void parse(int argc, char **argv);
+        bool parse(int argc, char **argv);
+
+        /**
+         * Parse the command line arguments into a separate result without printing or exiting.
+         * The options_manager itself is not modified, so this can be called from several threads at once.
+         * @param argc the number of arguments
+         * @param argv the arguments, the first one is the program name and is skipped
+         * @param result the result to fill, it is reset first
+         * @throws parse_error if the arguments do not match the schema
+         */
+        void parse_into(int argc, char **argv, parse_result &result) const;
+
+        /**
+         * Parse the command line arguments into a separate result, handing each option to a sink as it is recognized.
+         * @param argc the number of arguments
+         * @param argv the arguments, the first one is the program name and is skipped
+         * @param result the result to fill, it is reset first
+         * @param sink receives the options in the order they were given
+         * @throws parse_error if the arguments do not match the schema or the sink rejects a value
+         */
+        void parse_into(int argc, char **argv, parse_result &result, option_sink &sink) const;
+
+        /**
+         * Set the number of arguments above which parsing classifies the arguments on several threads before resolving them in order.
+         * This only pays off for very long argument lists, such as hundreds of thousands of file names.
+         * @param threshold the number of arguments, the default is 65536
+         */
+        void set_parallel_threshold(size_t threshold);
+
+        /**
+         * Check that option arguments and operands are valid UTF-8 while parsing, which fails the parse otherwise.
+         * event_stream reports them as invalid_utf8 errors and incremental_parser as invalid_utf8 tokens. This is off by default.
+         * @param enabled whether or not to validate
+         */
+        void set_utf8_validation(bool enabled);
+
+        /**
+         * Set the width the help is laid out for. Descriptions are aligned in a column after the option names and wrapped to this width.
+         * @param columns the width in terminal columns, or 0 to use the COLUMNS environment variable or the width of the terminal, falling back to 80
+         */
+        void set_help_width(size_t columns);
 
         /**
          * Print the help message to stdout.
@@ -113,6 +359,127 @@ namespace cclip
          */
         option *get_option(const std::string &name);
 
+        /**
+         * Get the id of the value given to a choice option.
+         * @tparam T the enum or integer type the ids were declared with
+         * @param name the short or long name of the option
+         * @param fallback the value to return if the option is not present and has no default
+         * @return the id of the value, of the default value, or the fallback
+         */
+        template<typename T = int>
+        T get_choice(const std::string &name, T fallback = T{})
+        {
+            const option *opt = this->find_option(name);
+            return opt == nullptr ? fallback : this->get_choice<T>(option_handle{opt->index}, fallback);
+        }
+
+        /**
+         * Check if the option is present in the arguments.
+         * @param handle the handle returned by add_option
+         * @return whether or not the option is present
+         */
+        [[nodiscard]] bool is_present(const option_handle handle) const
+        {
+            return this->result.is_present(handle);
+        }
+
+        /**
+         * Get the argument of the option.
+         * @param handle the handle returned by add_option
+         * @return the argument, or nullptr if the option is not present or has no argument
+         */
+        [[nodiscard]] const char *get(const option_handle handle) const
+        {
+            return this->result.get(handle);
+        }
+
+        /**
+         * Get the argument of the option, or its default value if it was not given.
+         * @param handle the handle returned by add_option
+         * @return the argument, the default value, or nullptr if the option has neither
+         */
+        [[nodiscard]] const char *get_or_default(option_handle handle) const;
+
+        /**
+         * Get the argument of the option in a separate result, or its default value if it was not given.
+         * @param result a result filled by parse_into
+         * @param handle the handle returned by add_option
+         * @return the argument, the default value, or nullptr if the option has neither
+         */
+        [[nodiscard]] const char *get_or_default(const parse_result &result, option_handle handle) const;
+
+        /**
+         * Get the operand given for a named positional argument.
+         * @param handle the handle returned by add_positional
+         * @return the operand, or nullptr if it was not given
+         */
+        [[nodiscard]] const char *get(positional_handle handle) const;
+
+        /**
+         * Get every operand, the arguments that are not options or option arguments, in the order they were given.
+         * Everything after a -- argument is an operand. The span points into the parsed argv, whose operands parse moved to the end, behind the options.
+         * @return the operands
+         */
+        [[nodiscard]] operand_span get_operands() const;
+
+        /**
+         * Get the operands that belong to the variadic argument, every operand after the named positional arguments.
+         * @return the operands
+         */
+        [[nodiscard]] operand_span get_variadic() const;
+
+        /**
+         * Get the positional arguments in the order they were added, with the variadic argument last.
+         * @return the positional arguments
+         */
+        [[nodiscard]] const std::vector<positional> &get_positionals() const;
+
+        /**
+         * Get the id of the value given to a choice option.
+         * @tparam T the enum or integer type the ids were declared with
+         * @param handle the handle returned by add_choice_option
+         * @param fallback the value to return if the option is not present and has no default
+         * @return the id of the value, of the default value, or the fallback
+         */
+        template<typename T = int>
+        [[nodiscard]] T get_choice(const option_handle handle, T fallback = T{}) const
+        {
+            int value = this->result.get_choice_value(handle);
+            if (value == -1 && handle.index < this->options.size() && this->options[handle.index]->defaults != nullptr)
+            {
+                value = this->options[handle.index]->defaults->get_choice_value();
+            }
+            return value == -1 ? fallback : static_cast<T>(value);
+        }
+
+        /**
+         * Find an option in the schema by name, whether or not it was given on the command line.
+         * @param name the short or long name of the option
+         * @return the option, or nullptr if there is no option with that name
+         */
+        [[nodiscard]] const option *find_option(std::string_view name) const;
+
+        /**
+         * Find the option names closest to a misspelled one, by edit distance.
+         * @param name the misspelled name minus the dashes
+         * @param max_results the maximum number of suggestions
+         * @return the suggestions, closest first
+         */
+        [[nodiscard]] std::vector<suggestion> suggest(const std::string &name, size_t max_results = 3) const;
+
+        /**
+         * Get every option in the schema, in the order they were added.
+         * The position of an option in this list is the index of its handle.
+         * @return the options
+         */
+        [[nodiscard]] const std::vector<option *> &get_options() const;
+
+        /**
+         * Get the result of the last parse.
+         * @return the parse result
+         */
+        [[nodiscard]] const parse_result &get_result() const;
+
         /**
          * Builds a PowerShell script snippet for autocomplete feature.
          *
@@ -0,0 +1,47 @@
+#pragma once
+
+#ifndef PARSE_ERROR_H
+#define PARSE_ERROR_H
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cclip
+{
+    /**
+     * Thrown by options_manager::parse_into when the arguments do not match the schema.
+     * The message is the same one parse prints before exiting.
+     */
+    class parse_error : public std::runtime_error
+    {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    /**
+     * Thrown when an argument looks like an option but is not in the schema.
+     * It carries the closest option names, which are also listed in the message.
+     */
+    class unknown_option_error : public parse_error
+    {
+    private:
+        std::vector<std::string> suggestions;
+
+    public:
+        unknown_option_error(const std::string &message, std::vector<std::string> suggestions) : parse_error(message), suggestions(std::move(suggestions))
+        {
+        }
+
+        /**
+         * Get the closest option names, with their dashes, closest first.
+         * @return the suggestions, empty if no option name is close enough
+         */
+        [[nodiscard]] const std::vector<std::string> &get_suggestions() const
+        {
+            return this->suggestions;
+        }
+    };
+}
+#endif
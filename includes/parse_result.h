@@ -0,0 +1,110 @@
+#pragma once
+
+#ifndef PARSE_RESULT_H
+#define PARSE_RESULT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "config.h"
+#include "operand_span.h"
+#include "option_handle.h"
+
+namespace cclip
+{
+    /**
+     * The options found by a parse, indexed by option handle.
+     * Presence is kept as a bitset and arguments as a flat array, so queries never touch the option names.
+     */
+    class parse_result
+    {
+    private:
+        std::vector<std::uint64_t> present;
+        std::vector<char *> arguments;
+        std::vector<int> choice_values;
+        operand_span operands;
+        // Scratch space for the arguments parse moves in front of the operands, kept to reuse its capacity
+        std::vector<char *> displaced;
+
+        friend class options_manager;
+
+    public:
+        /**
+         * Clear the result and size it for a schema.
+         * @param option_count the number of options in the schema
+         */
+        void reset(size_t option_count);
+
+        /**
+         * Mark an option as present.
+         * @param index the index of the option in the schema
+         * @param argument the argument of the option, or nullptr if it has none
+         * @param choice_value the id of the value of a choice option, or -1
+         */
+        void set(std::uint32_t index, char *argument = nullptr, int choice_value = -1);
+
+        /**
+         * Set the operands of the parse.
+         * @param operands the operands, in the argv that was parsed
+         */
+        void set_operands(operand_span operands);
+
+        /**
+         * Check if the option is present.
+         * @param handle the option
+         * @return whether or not the option is present
+         */
+        [[nodiscard]] bool is_present(const option_handle handle) const
+        {
+            return handle.index / 64 < this->present.size() && (this->present[handle.index / 64] >> (handle.index % 64) & 1) != 0;
+        }
+
+        /**
+         * Get the argument of the option.
+         * @param handle the option
+         * @return the argument, or nullptr if the option is not present or has no argument
+         */
+        [[nodiscard]] char *get(const option_handle handle) const
+        {
+            return handle.index < this->arguments.size() ? this->arguments[handle.index] : nullptr;
+        }
+
+        /**
+         * Get the id of the value given to a choice option.
+         * @param handle the option
+         * @return the id, or -1 if the option is not present or is not a choice option
+         */
+        [[nodiscard]] int get_choice_value(const option_handle handle) const
+        {
+            return handle.index < this->choice_values.size() ? this->choice_values[handle.index] : -1;
+        }
+
+        /**
+         * Get the number of options in the schema the result was parsed with.
+         * @return the number of options
+         */
+        [[nodiscard]] size_t get_option_count() const
+        {
+            return this->arguments.size();
+        }
+
+        /**
+         * Get the presence bitset, bit i of word i / 64 is set if the option with index i is present.
+         * @return the bitset
+         */
+        [[nodiscard]] const std::vector<std::uint64_t> &get_presence() const
+        {
+            return this->present;
+        }
+
+        /**
+         * Get the operands, the arguments that are not options or option arguments, in the order they were given.
+         * @return a view into the argv that was parsed
+         */
+        [[nodiscard]] operand_span get_operands() const
+        {
+            return this->operands;
+        }
+    };
+}
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+
+#ifndef POSITIONAL_H
+#define POSITIONAL_H
+
+namespace cclip
+{
+    struct positional
+    {
+        /**
+         * The name of the argument as it is shown in the help (e.g. source).
+         */
+        const char *name;
+        /**
+         * The description of the argument.
+         */
+        const char *description;
+        /**
+         * Whether or not the argument is required. For the variadic tail this means at least one operand.
+         */
+        bool is_required;
+        /**
+         * Whether or not this is the variadic tail that takes every remaining operand.
+         */
+        bool is_variadic;
+    };
+}
+#endif
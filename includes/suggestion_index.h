@@ -0,0 +1,126 @@
+#pragma once
+
+#ifndef SUGGESTION_INDEX_H
+#define SUGGESTION_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "config.h"
+
+namespace cclip
+{
+    struct suggestion
+    {
+        /**
+         * The name of the option minus the dashes.
+         */
+        const char *name;
+        /**
+         * Whether or not the name is a long name (--name) rather than a short one (-n).
+         */
+        bool is_long;
+        /**
+         * The index of the option in the schema.
+         */
+        std::uint32_t option;
+        /**
+         * The edit distance between the name and the unknown option.
+         */
+        size_t distance;
+    };
+
+    /**
+     * Finds the option names closest to a misspelled one.
+     * Each candidate is compared with the bit-parallel edit distance of Myers (as adapted by Hyyrö), which takes one pass of a few word
+     * operations per character. Candidates whose length or set of characters differs by more edits than allowed are skipped before that.
+     * The names are also indexed by their bigrams and trigrams: an edit changes at most one of a set of pieces of the misspelled name that
+     * do not overlap, so a name within k edits contains at least one of any k + 1 of them, and only the names listed under the k + 1 pieces
+     * with the fewest names are visited. Trigrams that span two words of a name are usually rare, which keeps that list short.
+     * A misspelled name too short for k + 1 bigrams, or whose pieces list more names than the nearby lengths hold, is compared with every
+     * name of a nearby length instead.
+     */
+    class suggestion_index
+    {
+    private:
+        struct entry
+        {
+            const char *name;
+            size_t length;
+            std::uint32_t option;
+            bool is_long;
+        };
+
+        // The size of the list is kept in the slot, so choosing the pieces to look up reads nothing but the table
+        struct gram_slot
+        {
+            std::uint32_t key;
+            std::uint32_t list;
+            std::uint32_t size;
+        };
+
+        // The length and character set are copied next to the entry, so the filtering passes read one dense array and nothing else
+        struct posting
+        {
+            std::uint64_t characters;
+            std::uint32_t entry;
+            std::uint32_t length;
+        };
+
+        /**
+         * The longest name that is indexed by its bigrams. Bigrams are only looked up for a misspelled name shorter than 12 characters, which
+         * matches names at most 3 characters longer.
+         */
+        static constexpr size_t max_bigram_length = 14;
+
+        std::vector<entry> entries;
+        /**
+         * The entries of each name length, in the order they were added.
+         */
+        std::vector<std::vector<posting> > buckets;
+        /**
+         * The entries whose name contains each bigram or trigram, sorted by length and then in the order they were added. Only the names
+         * up to max_bigram_length are listed under their bigrams.
+         */
+        std::vector<std::vector<posting> > postings;
+        /**
+         * Open addressing from bigram or trigram to posting list, at most half full. A slot is free when its key is 0, since no gram of a
+         * name contains a null character.
+         */
+        std::vector<gram_slot> gram_slots;
+
+        static std::uint32_t gram(const char *text, size_t size);
+
+        [[nodiscard]] size_t home(std::uint32_t key) const;
+
+        void place(const gram_slot &slot);
+
+        [[nodiscard]] size_t find_gram(std::uint32_t key) const;
+
+        void index_gram(std::uint32_t key, const posting &added);
+
+        static std::uint64_t character_set(const char *text, size_t length);
+
+        static size_t distance(const unsigned char *slots, const std::uint64_t *peq, const char *pattern, size_t pattern_length, const char *text, size_t text_length, size_t limit);
+
+    public:
+        /**
+         * Add an option name.
+         * @param name the name minus the dashes
+         * @param option the index of the option in the schema
+         * @param is_long whether or not the name is a long name
+         */
+        void add(const char *name, std::uint32_t option, bool is_long);
+
+        /**
+         * Find the names closest to a misspelled one, at most a third of its length and 1 to 3 edits away.
+         * Only the first 64 characters of the name are compared.
+         * @param name the misspelled name minus the dashes
+         * @param max_results the maximum number of suggestions
+         * @return the suggestions, closest first, with at most one per option
+         */
+        [[nodiscard]] std::vector<suggestion> find(std::string_view name, size_t max_results = 3) const;
+    };
+}
+#endif
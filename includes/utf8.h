@@ -0,0 +1,48 @@
+#pragma once
+
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "config.h"
+
+namespace cclip
+{
+    /**
+     * Check that text is well-formed UTF-8: no stray continuation bytes, truncated sequences, overlong encodings, surrogates or code points above U+10FFFF.
+     * Runs of ASCII are checked 16 bytes at a time where SSE2 is available.
+     * @param text the text
+     * @return whether or not the text is valid UTF-8
+     */
+    bool is_valid_utf8(std::string_view text);
+
+    /**
+     * Get the number of terminal columns text takes up.
+     * East Asian wide characters and most emoji take two columns, combining marks, zero-width characters and control characters none, and everything else one.
+     * Each byte of an invalid sequence counts as one column, like the replacement character a terminal shows for it.
+     * @param text the UTF-8 text
+     * @return the width in columns
+     */
+    size_t display_width(std::string_view text);
+
+    namespace detail
+    {
+        /**
+         * Decode one code point and move past it.
+         * @param position the first byte of the code point, moved past it, or one byte on an invalid sequence
+         * @param end the end of the text
+         * @return the code point, or -1 if the sequence is invalid
+         */
+        std::int32_t decode_utf8(const unsigned char *&position, const unsigned char *end);
+
+        /**
+         * Get the number of terminal columns a code point takes up, see display_width.
+         * @param code_point the code point
+         * @return 0, 1 or 2
+         */
+        size_t code_point_width(std::int32_t code_point);
+    }
+}
+#endif
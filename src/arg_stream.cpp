@@ -0,0 +1,141 @@
+#include "arg_stream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <io.h>
+#endif
+
+CCLIP_INLINE cclip::arg_stream::arg_stream(std::FILE *file, const char delimiter, const size_t capacity) : file(file), owns_file(false), delimiter(delimiter), buffer(capacity + 1), begin_offset(0), end_offset(0), at_end(false)
+{
+}
+
+CCLIP_INLINE cclip::arg_stream::arg_stream(arg_stream &&other) noexcept : file(other.file), owns_file(other.owns_file), delimiter(other.delimiter), buffer(std::move(other.buffer)), begin_offset(other.begin_offset), end_offset(other.end_offset), at_end(other.at_end)
+{
+    other.file = nullptr;
+    other.owns_file = false;
+}
+
+CCLIP_INLINE cclip::arg_stream::~arg_stream()
+{
+    if (this->owns_file && this->file != nullptr)
+    {
+        std::fclose(this->file);
+    }
+}
+
+CCLIP_INLINE cclip::arg_stream cclip::arg_stream::open(const char *path, const char delimiter, const size_t capacity)
+{
+    if (std::strcmp(path, "-") == 0)
+    {
+        return arg_stream(stdin, delimiter, capacity);
+    }
+    std::FILE *file = std::fopen(path, "rb");
+    if (file == nullptr)
+    {
+        throw std::runtime_error("Unable to open argument file: " + std::string(path));
+    }
+    arg_stream stream(file, delimiter, capacity);
+    stream.owns_file = true;
+    return stream;
+}
+
+CCLIP_INLINE size_t cclip::arg_stream::read_some(char *data, const size_t count)
+{
+    // A short read returns whatever a pipe holds, where fread would wait until the buffer is full
+#if defined(__unix__) || defined(__APPLE__)
+    for (;;)
+    {
+        const ssize_t read = ::read(fileno(this->file), data, count);
+        if (read >= 0)
+        {
+            return static_cast<size_t>(read);
+        }
+        if (errno != EINTR)
+        {
+            throw std::runtime_error("Unable to read arguments");
+        }
+    }
+#elif defined(_WIN32)
+    const int read = _read(_fileno(this->file), data, static_cast<unsigned int>(std::min<size_t>(count, 1u << 30)));
+    if (read < 0)
+    {
+        throw std::runtime_error("Unable to read arguments");
+    }
+    return static_cast<size_t>(read);
+#else
+    const size_t read = std::fread(data, 1, count, this->file);
+    if (read == 0 && std::ferror(this->file))
+    {
+        throw std::runtime_error("Unable to read arguments");
+    }
+    return read;
+#endif
+}
+
+CCLIP_INLINE bool cclip::arg_stream::next(std::string_view &arg)
+{
+    // The last byte of the buffer is kept free so the final argument can be NUL-terminated too
+    const size_t capacity = this->buffer.size() - 1;
+    for (;;)
+    {
+        char *data = this->buffer.data();
+        const auto *found = static_cast<char *>(std::memchr(data + this->begin_offset, this->delimiter, this->end_offset - this->begin_offset));
+        size_t length;
+        if (found != nullptr)
+        {
+            length = found - (data + this->begin_offset);
+        } else if (this->at_end)
+        {
+            if (this->begin_offset == this->end_offset)
+            {
+                return false;
+            }
+            length = this->end_offset - this->begin_offset;
+        } else
+        {
+            // Move the partial argument to the front and fill the rest of the buffer
+            if (this->begin_offset > 0)
+            {
+                std::memmove(data, data + this->begin_offset, this->end_offset - this->begin_offset);
+                this->end_offset -= this->begin_offset;
+                this->begin_offset = 0;
+            }
+            if (this->end_offset == capacity)
+            {
+                throw std::runtime_error("Argument is longer than " + std::to_string(capacity) + " bytes");
+            }
+            const size_t read = this->read_some(data + this->end_offset, capacity - this->end_offset);
+            this->end_offset += read;
+            if (read == 0)
+            {
+                this->at_end = true;
+            }
+            continue;
+        }
+
+        char *start = data + this->begin_offset;
+        start[length] = '\0';
+        this->begin_offset = std::min(this->begin_offset + length + 1, this->end_offset);
+        if (this->delimiter == '\n')
+        {
+            if (length > 0 && start[length - 1] == '\r')
+            {
+                start[--length] = '\0';
+            }
+            if (length == 0)
+            {
+                continue;
+            }
+        }
+        arg = std::string_view(start, length);
+        return true;
+    }
+}
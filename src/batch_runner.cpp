@@ -0,0 +1,235 @@
+#include "batch_runner.h"
+#include "options_manager.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace cclip
+{
+    namespace detail
+    {
+        struct batch_slot
+        {
+            size_t line = 0;
+            std::string text;
+            std::string buffer;
+            std::vector<size_t> offsets;
+            std::vector<char *> argv;
+            parse_result result;
+            bool parsed = false;
+            std::exception_ptr error;
+        };
+
+        // Read the next command line into the slot, skipping blank lines
+        CCLIP_INLINE bool read_command_line(std::istream &input, const char delimiter, batch_slot &slot, size_t &line)
+        {
+            while (std::getline(input, slot.text, delimiter))
+            {
+                ++line;
+                if (slot.text.find_first_not_of(" \t\r") != std::string::npos)
+                {
+                    slot.line = line;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Split a command line into NUL-terminated arguments the way a POSIX shell would, without expansions
+        CCLIP_INLINE void split_command_line(batch_slot &slot)
+        {
+            slot.buffer.clear();
+            slot.offsets.clear();
+            slot.buffer.push_back('\0'); // argv[0]
+            slot.offsets.push_back(0);
+
+            const std::string &text = slot.text;
+            size_t i = 0;
+            while (i < text.size())
+            {
+                while (i < text.size() && (text[i] == ' ' || text[i] == '\t' || text[i] == '\r'))
+                {
+                    ++i;
+                }
+                if (i >= text.size())
+                {
+                    break;
+                }
+                slot.offsets.push_back(slot.buffer.size());
+                char quote = 0;
+                for (; i < text.size(); ++i)
+                {
+                    const char c = text[i];
+                    if (quote == '\'')
+                    {
+                        if (c == '\'')
+                            quote = 0;
+                        else
+                            slot.buffer.push_back(c);
+                    } else if (c == '\\' && i + 1 < text.size() && (quote == 0 || text[i + 1] == '"' || text[i + 1] == '\\'))
+                    {
+                        slot.buffer.push_back(text[++i]);
+                    } else if (quote == '"')
+                    {
+                        if (c == '"')
+                            quote = 0;
+                        else
+                            slot.buffer.push_back(c);
+                    } else if (c == '\'' || c == '"')
+                    {
+                        quote = c;
+                    } else if (c == ' ' || c == '\t' || c == '\r')
+                    {
+                        break;
+                    } else
+                    {
+                        slot.buffer.push_back(c);
+                    }
+                }
+                slot.buffer.push_back('\0');
+            }
+
+            slot.argv.clear();
+            for (const size_t offset: slot.offsets)
+            {
+                slot.argv.push_back(&slot.buffer[offset]);
+            }
+        }
+    }
+}
+
+CCLIP_INLINE cclip::batch_runner::batch_runner(const options_manager &schema, const char delimiter) : schema(schema), delimiter(delimiter)
+{
+}
+
+CCLIP_INLINE size_t cclip::batch_runner::run(std::istream &input, const command_handler &on_command, const error_handler &on_error) const
+{
+    // Lines are read here and split and parsed on a worker thread while the handler of an earlier line runs. A line is only read ahead
+    // while the stream already holds buffered input, so a parsed command never waits for the next line to arrive, and nothing is left
+    // blocked on the stream when a handler throws. A few slots are recycled so their buffers are only allocated once
+    constexpr size_t slot_count = 4;
+    detail::batch_slot slots[slot_count];
+    std::vector<detail::batch_slot *> free_slots;
+    for (auto &slot: slots)
+    {
+        free_slots.push_back(&slot);
+    }
+    std::deque<detail::batch_slot *> in_flight; // read and not yet dispatched, in input order
+    std::deque<detail::batch_slot *> queued; // waiting for the worker
+    std::mutex mutex;
+    std::condition_variable slot_queued;
+    std::condition_variable slot_parsed;
+    bool stopping = false;
+
+    std::thread worker([&]
+    {
+        for (;;)
+        {
+            detail::batch_slot *slot;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                slot_queued.wait(lock, [&] { return stopping || !queued.empty(); });
+                if (stopping)
+                {
+                    break;
+                }
+                slot = queued.front();
+                queued.pop_front();
+            }
+
+            detail::split_command_line(*slot);
+            slot->error = nullptr;
+            try
+            {
+                this->schema.parse_into(static_cast<int>(slot->argv.size()), slot->argv.data(), slot->result);
+            } catch (const parse_error &)
+            {
+                slot->error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            slot->parsed = true;
+            slot_parsed.notify_one();
+        }
+    });
+
+    size_t line = 0;
+    bool input_done = false;
+    size_t dispatched = 0;
+    std::exception_ptr failure;
+    for (;;)
+    {
+        std::streambuf *buffered = input.rdbuf();
+        if (!input_done && !free_slots.empty() && (in_flight.empty() || (buffered != nullptr && buffered->in_avail() > 0)))
+        {
+            detail::batch_slot *slot = free_slots.back();
+            if (!detail::read_command_line(input, this->delimiter, *slot, line))
+            {
+                input_done = true;
+                continue;
+            }
+            free_slots.pop_back();
+            in_flight.push_back(slot);
+            std::lock_guard<std::mutex> lock(mutex);
+            slot->parsed = false;
+            queued.push_back(slot);
+            slot_queued.notify_one();
+            continue;
+        }
+        if (in_flight.empty())
+        {
+            break;
+        }
+
+        detail::batch_slot *slot = in_flight.front();
+        in_flight.pop_front();
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            slot_parsed.wait(lock, [slot] { return slot->parsed; });
+        }
+        try
+        {
+            if (slot->error)
+            {
+                // Rethrown so the handler gets the original error, e.g. an unknown_option_error with its suggestions
+                try
+                {
+                    std::rethrow_exception(slot->error);
+                } catch (const parse_error &e)
+                {
+                    if (on_error)
+                        on_error(slot->line, e);
+                    else
+                        std::cerr << "Line " << slot->line << ": " << e.what() << std::endl;
+                }
+            } else
+            {
+                on_command(command{slot->line, static_cast<int>(slot->argv.size()), slot->argv.data(), slot->result});
+                ++dispatched;
+            }
+        } catch (...)
+        {
+            failure = std::current_exception();
+            break;
+        }
+        free_slots.push_back(slot);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    slot_queued.notify_one();
+    worker.join();
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
+    return dispatched;
+}
@@ -0,0 +1,170 @@
+#include "canonical.h"
+
+#include <bitset>
+#include <cstring>
+
+namespace cclip
+{
+    namespace detail
+    {
+        // Walks the canonical form of a result, feeding integers and byte ranges to a sink
+        template<typename Sink>
+        void write_canonical(const parse_result &result, Sink &sink)
+        {
+            const std::vector<std::uint64_t> &presence = result.get_presence();
+            size_t present = 0;
+            for (const std::uint64_t word: presence)
+            {
+                present += std::bitset<64>(word).count();
+            }
+            sink.integer(present);
+
+            for (size_t w = 0; w < presence.size(); ++w)
+            {
+                std::uint64_t bits = presence[w];
+                for (std::uint32_t bit = 0; bits != 0; ++bit, bits >>= 1)
+                {
+                    if ((bits & 1) == 0)
+                    {
+                        continue;
+                    }
+                    const auto index = static_cast<std::uint32_t>(w * 64 + bit);
+                    sink.integer(index);
+                    if (const char *value = result.get({index}); value != nullptr)
+                    {
+                        const size_t length = std::strlen(value);
+                        sink.integer(length + 1);
+                        sink.bytes(value, length);
+                    } else
+                    {
+                        sink.integer(0);
+                    }
+                }
+            }
+
+            const operand_span operands = result.get_operands();
+            sink.integer(operands.size());
+            for (const char *operand: operands)
+            {
+                const size_t length = std::strlen(operand);
+                sink.integer(length);
+                sink.bytes(operand, length);
+            }
+        }
+
+        class canonical_hasher
+        {
+        private:
+            std::uint64_t a;
+            std::uint64_t b;
+            std::uint64_t length;
+
+            static std::uint64_t rotate(const std::uint64_t value, const int bits)
+            {
+                return value << bits | value >> (64 - bits);
+            }
+
+            static std::uint64_t finish(std::uint64_t value)
+            {
+                // The murmur3 finalizer
+                value ^= value >> 33;
+                value *= 0xff51afd7ed558ccdULL;
+                value ^= value >> 33;
+                value *= 0xc4ceb9fe1a85ec53ULL;
+                value ^= value >> 33;
+                return value;
+            }
+
+            void word(const std::uint64_t value)
+            {
+                this->a = rotate((this->a ^ value) * 0x9e3779b97f4a7c15ULL, 31);
+                this->b = rotate((this->b + value) * 0xc2b2ae3d27d4eb4fULL, 29) ^ this->a;
+                ++this->length;
+            }
+
+        public:
+            explicit canonical_hasher(const std::uint64_t seed) : a(seed ^ 0x243f6a8885a308d3ULL), b(~seed ^ 0x13198a2e03707344ULL), length(0)
+            {
+            }
+
+            void integer(const std::uint64_t value)
+            {
+                this->word(value);
+            }
+
+            // Read as little-endian whatever the host is, so a hash can be compared across machines; compilers turn a full word into one load
+            static std::uint64_t load(const char *data, const size_t size)
+            {
+                std::uint64_t value = 0;
+                for (size_t i = 0; i < size; ++i)
+                {
+                    value |= std::uint64_t{static_cast<unsigned char>(data[i])} << (8 * i);
+                }
+                return value;
+            }
+
+            void bytes(const char *data, size_t size)
+            {
+                for (; size >= 8; data += 8, size -= 8)
+                {
+                    this->word(load(data, 8));
+                }
+                if (size > 0)
+                {
+                    this->word(load(data, size));
+                }
+            }
+
+            hash128 digest() const
+            {
+                const std::uint64_t low = finish(this->a ^ this->length);
+                const std::uint64_t high = finish(this->b + low);
+                return hash128{low, high};
+            }
+        };
+
+        class canonical_writer
+        {
+        private:
+            std::vector<unsigned char> &out;
+
+        public:
+            explicit canonical_writer(std::vector<unsigned char> &out) : out(out)
+            {
+            }
+
+            void integer(std::uint64_t value)
+            {
+                for (; value >= 0x80; value >>= 7)
+                {
+                    this->out.push_back(static_cast<unsigned char>(value | 0x80));
+                }
+                this->out.push_back(static_cast<unsigned char>(value));
+            }
+
+            void bytes(const char *data, const size_t size)
+            {
+                this->out.insert(this->out.end(), data, data + size);
+            }
+        };
+    }
+}
+
+CCLIP_INLINE std::uint64_t cclip::canonical_hash64(const parse_result &result, const std::uint64_t seed)
+{
+    return canonical_hash128(result, seed).low;
+}
+
+CCLIP_INLINE cclip::hash128 cclip::canonical_hash128(const parse_result &result, const std::uint64_t seed)
+{
+    detail::canonical_hasher hasher(seed);
+    detail::write_canonical(result, hasher);
+    return hasher.digest();
+}
+
+CCLIP_INLINE void cclip::serialize_canonical(const parse_result &result, std::vector<unsigned char> &out)
+{
+    out.push_back(1); // format version
+    detail::canonical_writer writer(out);
+    detail::write_canonical(result, writer);
+}
@@ -0,0 +1,84 @@
+#include "choice_table.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+CCLIP_INLINE std::uint32_t cclip::choice_table::hash(const std::string_view value, const std::uint32_t seed)
+{
+    // FNV-1a with the seed folded into the offset basis
+    std::uint32_t h = 2166136261u ^ seed;
+    for (const char c: value)
+    {
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    h ^= h >> 16;
+    return h;
+}
+
+CCLIP_INLINE cclip::choice_table::choice_table(std::vector<choice> choices) : choices(std::move(choices)), seed(0), mask(0)
+{
+    for (size_t i = 0; i < this->choices.size(); ++i)
+    {
+        for (size_t j = i + 1; j < this->choices.size(); ++j)
+        {
+            if (std::strcmp(this->choices[i].name, this->choices[j].name) == 0)
+            {
+                throw std::invalid_argument("Duplicate choice value: " + std::string(this->choices[i].name));
+            }
+        }
+    }
+
+    size_t size = 1;
+    while (size < this->choices.size() * 2)
+    {
+        size <<= 1;
+    }
+
+    // Try seeds until every value lands in its own slot, growing the table if a size turns out to be too tight
+    for (;; size <<= 1)
+    {
+        this->mask = static_cast<std::uint32_t>(size - 1);
+        for (this->seed = 0; this->seed < 256; ++this->seed)
+        {
+            this->slots.assign(size, -1);
+            bool collided = false;
+            for (size_t i = 0; i < this->choices.size() && !collided; ++i)
+            {
+                std::int32_t &slot = this->slots[hash(this->choices[i].name, this->seed) & this->mask];
+                collided = slot != -1;
+                slot = static_cast<std::int32_t>(i);
+            }
+            if (!collided)
+            {
+                return;
+            }
+        }
+    }
+}
+
+CCLIP_INLINE const cclip::choice *cclip::choice_table::find(const char *value) const
+{
+    return value == nullptr ? nullptr : this->find(std::string_view(value));
+}
+
+CCLIP_INLINE const cclip::choice *cclip::choice_table::find(const std::string_view value) const
+{
+    if (this->slots.empty())
+    {
+        return nullptr;
+    }
+    const std::int32_t slot = this->slots[hash(value, this->seed) & this->mask];
+    if (slot == -1 || value != this->choices[slot].name)
+    {
+        return nullptr;
+    }
+    return &this->choices[slot];
+}
+
+CCLIP_INLINE const std::vector<cclip::choice> &cclip::choice_table::get_choices() const
+{
+    return this->choices;
+}
@@ -0,0 +1,233 @@
+#include "config_reloader.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+struct alignas(64) cclip::config_reloader::hazard_slot
+{
+    std::atomic<const config_snapshot *> pointer{nullptr};
+    std::atomic<bool> claimed{false};
+};
+
+struct cclip::config_reloader::shared_state
+{
+    std::atomic<const config_snapshot *> current{nullptr};
+    hazard_slot hazards[max_readers];
+    std::vector<const config_snapshot *> retired;
+    std::mutex reload_mutex;
+    std::atomic<bool> running{false};
+    std::thread watcher;
+    callback<void(const std::exception &)> error_handler;
+};
+
+CCLIP_INLINE cclip::config_reloader::reader::reader(hazard_slot *slot, const config_snapshot *snapshot) : slot(slot), snapshot(snapshot)
+{
+}
+
+CCLIP_INLINE cclip::config_reloader::reader::reader(reader &&other) noexcept : slot(other.slot), snapshot(other.snapshot)
+{
+    other.slot = nullptr;
+}
+
+CCLIP_INLINE cclip::config_reloader::reader::~reader()
+{
+    if (this->slot != nullptr)
+    {
+        this->slot->pointer.store(nullptr, std::memory_order_release);
+        this->slot->claimed.store(false, std::memory_order_release);
+    }
+}
+
+CCLIP_INLINE cclip::config_reloader::config_reloader(const options_manager &schema, std::string path) : schema(schema), path(std::move(path)), state(nullptr)
+{
+    auto first = std::make_unique<config_snapshot>(this->schema, this->path);
+    this->state = new shared_state();
+    this->state->current.store(first.release(), std::memory_order_release);
+}
+
+CCLIP_INLINE cclip::config_reloader::~config_reloader()
+{
+    this->stop();
+    for (const config_snapshot *snapshot: this->state->retired)
+    {
+        delete snapshot;
+    }
+    delete this->state->current.load(std::memory_order_acquire);
+    delete this->state;
+}
+
+CCLIP_INLINE void cclip::config_reloader::start()
+{
+    if (this->state->running.exchange(true))
+    {
+        return;
+    }
+    this->state->watcher = std::thread(&config_reloader::watch, this);
+}
+
+CCLIP_INLINE void cclip::config_reloader::stop()
+{
+    this->state->running.store(false);
+    if (this->state->watcher.joinable())
+    {
+        this->state->watcher.join();
+    }
+}
+
+CCLIP_INLINE bool cclip::config_reloader::reload()
+{
+    std::unique_ptr<config_snapshot> next;
+    try
+    {
+        next = std::make_unique<config_snapshot>(this->schema, this->path);
+    } catch (const std::exception &e)
+    {
+        this->report(e);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(this->state->reload_mutex);
+    this->state->retired.push_back(this->state->current.exchange(next.release(), std::memory_order_seq_cst));
+    this->reclaim();
+    return true;
+}
+
+CCLIP_INLINE cclip::config_reloader::reader cclip::config_reloader::read() const
+{
+    // Start at a slot derived from the thread so concurrent readers rarely compete for the same one
+    const size_t start = std::hash<std::thread::id>{}(std::this_thread::get_id()) % max_readers;
+    for (size_t i = start;; i = (i + 1) % max_readers)
+    {
+        hazard_slot &slot = this->state->hazards[i];
+        bool expected = false;
+        if (!slot.claimed.load(std::memory_order_relaxed) && slot.claimed.compare_exchange_strong(expected, true, std::memory_order_acquire))
+        {
+            // Publish the pointer, then make sure it was not swapped out before the publication became visible
+            const config_snapshot *snapshot = this->state->current.load(std::memory_order_seq_cst);
+            for (;;)
+            {
+                slot.pointer.store(snapshot, std::memory_order_seq_cst);
+                const config_snapshot *latest = this->state->current.load(std::memory_order_seq_cst);
+                if (latest == snapshot)
+                {
+                    return reader(&slot, snapshot);
+                }
+                snapshot = latest;
+            }
+        }
+        if ((i + 1) % max_readers == start)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+CCLIP_INLINE void cclip::config_reloader::on_error(callback<void(const std::exception &)> handler)
+{
+    this->state->error_handler = std::move(handler);
+}
+
+CCLIP_INLINE void cclip::config_reloader::reclaim()
+{
+    std::vector<const config_snapshot *> still_read;
+    for (const config_snapshot *snapshot: this->state->retired)
+    {
+        bool in_use = false;
+        for (const hazard_slot &slot: this->state->hazards)
+        {
+            if (slot.pointer.load(std::memory_order_seq_cst) == snapshot)
+            {
+                in_use = true;
+                break;
+            }
+        }
+        if (in_use)
+        {
+            still_read.push_back(snapshot);
+        } else
+        {
+            delete snapshot;
+        }
+    }
+    this->state->retired = std::move(still_read);
+}
+
+CCLIP_INLINE void cclip::config_reloader::report(const std::exception &error) const
+{
+    if (this->state->error_handler)
+    {
+        this->state->error_handler(error);
+        return;
+    }
+    std::cerr << "Failed to reload config file " << this->path << ": " << error.what() << std::endl;
+}
+
+CCLIP_INLINE void cclip::config_reloader::watch()
+{
+    const std::filesystem::path file(this->path);
+#ifdef __linux__
+    // Watch the directory rather than the file, editors often replace the file instead of writing to it
+    const std::string directory = file.has_parent_path() ? file.parent_path().string() : ".";
+    const std::string name = file.filename().string();
+    const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd >= 0 && inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) >= 0)
+    {
+        alignas(inotify_event) char events[4096];
+        while (this->state->running.load())
+        {
+            pollfd descriptor{fd, POLLIN, 0};
+            if (poll(&descriptor, 1, 250) <= 0)
+            {
+                continue;
+            }
+            bool changed = false;
+            ssize_t length;
+            while ((length = ::read(fd, events, sizeof(events))) > 0)
+            {
+                for (const char *ptr = events; ptr < events + length;)
+                {
+                    const auto *event = reinterpret_cast<const inotify_event *>(ptr);
+                    changed |= event->len > 0 && name == event->name;
+                    ptr += sizeof(inotify_event) + event->len;
+                }
+            }
+            if (changed)
+            {
+                this->reload();
+            }
+        }
+        close(fd);
+        return;
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+#endif
+    std::error_code error;
+    auto last_write = std::filesystem::last_write_time(file, error);
+    while (this->state->running.load())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        const auto write = std::filesystem::last_write_time(file, error);
+        if (!error && write != last_write)
+        {
+            last_write = write;
+            this->reload();
+        }
+    }
+}
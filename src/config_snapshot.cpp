@@ -0,0 +1,84 @@
+#include "config_snapshot.h"
+#include "options_manager.h"
+
+#include <fstream>
+#include <string>
+#include <sstream>
+#include <stdexcept>
+
+CCLIP_INLINE cclip::config_snapshot::config_snapshot(const options_manager &schema, const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("Unable to read config file: " + path);
+    }
+    std::stringstream content;
+    content << file.rdbuf();
+
+    // Rewrite every entry as command line tokens ("--name", "value") so the file is validated by the same parser as argv
+    std::vector<size_t> offsets;
+    offsets.push_back(0);
+    this->buffer.append(path).push_back('\0');
+
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(content, line))
+    {
+        ++line_number;
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+        {
+            continue;
+        }
+        const size_t last = line.find_last_not_of(" \t\r");
+        line = line.substr(first, last - first + 1);
+
+        const size_t separator = line.find('=');
+        std::string name = line.substr(0, separator);
+        name.erase(name.find_last_not_of(" \t") + 1);
+        if (name.empty())
+        {
+            // It would become the -- terminator and turn the value into an operand
+            throw parse_error("Missing option name (line " + std::to_string(line_number) + ")");
+        }
+
+        // Without this check a bare name would take the next entry as its argument, and a value given to a flag would become an operand
+        const option *opt = schema.find_option(name);
+        if (opt != nullptr && opt->has_argument && separator == std::string::npos)
+        {
+            throw parse_error("Missing value for option: " + name + " (line " + std::to_string(line_number) + ")");
+        }
+        if (opt != nullptr && !opt->has_argument && separator != std::string::npos)
+        {
+            throw parse_error("Option does not take a value: " + name + " (line " + std::to_string(line_number) + ")");
+        }
+        offsets.push_back(this->buffer.size());
+        this->buffer.append(name.size() == 1 ? "-" : "--").append(name).push_back('\0');
+
+        if (separator != std::string::npos)
+        {
+            std::string value = line.substr(separator + 1);
+            value.erase(0, value.find_first_not_of(" \t"));
+            if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+            {
+                value = value.substr(1, value.size() - 2);
+            }
+            offsets.push_back(this->buffer.size());
+            this->buffer.append(value).push_back('\0');
+        }
+    }
+
+    this->args.reserve(offsets.size());
+    for (const size_t offset: offsets)
+    {
+        this->args.push_back(&this->buffer[offset]);
+    }
+    // Only names and values: required options may still come from the command line, and a config file cannot give positional arguments
+    schema.parse_arguments(static_cast<int>(this->args.size()), this->args.data(), this->result, false, nullptr, false);
+}
+
+CCLIP_INLINE const cclip::parse_result &cclip::config_snapshot::get_result() const
+{
+    return this->result;
+}
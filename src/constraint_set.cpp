@@ -0,0 +1,59 @@
+#include "constraint_set.h"
+
+#include <algorithm>
+#include <bitset>
+
+CCLIP_INLINE void cclip::constraint_set::add(const std::vector<std::uint32_t> &trigger, const std::vector<std::uint32_t> &group, const std::uint32_t min_count, const std::uint32_t max_count, std::string message)
+{
+    std::uint32_t highest = 0;
+    for (const std::uint32_t index: trigger)
+    {
+        highest = std::max(highest, index);
+    }
+    for (const std::uint32_t index: group)
+    {
+        highest = std::max(highest, index);
+    }
+
+    // The trigger mask comes first, then the group mask, each as wide as the highest option index the rule mentions
+    const size_t words = highest / 64 + 1;
+    const size_t offset = this->masks.size();
+    this->masks.resize(offset + words * 2, 0);
+    for (const std::uint32_t index: trigger)
+    {
+        this->masks[offset + index / 64] |= std::uint64_t{1} << (index % 64);
+    }
+    for (const std::uint32_t index: group)
+    {
+        this->masks[offset + words + index / 64] |= std::uint64_t{1} << (index % 64);
+    }
+    this->rules.push_back(rule{offset, words, min_count, max_count, std::move(message)});
+}
+
+CCLIP_INLINE bool cclip::constraint_set::check(const std::vector<std::uint64_t> &presence, std::string &errors) const
+{
+    bool valid = true;
+    for (const rule &current: this->rules)
+    {
+        const std::uint64_t *trigger = this->masks.data() + current.offset;
+        const std::uint64_t *group = trigger + current.words;
+        std::uint64_t untriggered = 0;
+        size_t count = 0;
+        for (size_t w = 0; w < current.words; ++w)
+        {
+            const std::uint64_t present = w < presence.size() ? presence[w] : 0;
+            untriggered |= trigger[w] & ~present;
+            count += std::bitset<64>(present & group[w]).count();
+        }
+        if (untriggered == 0 && (count < current.min_count || count > current.max_count))
+        {
+            if (!errors.empty())
+            {
+                errors += "\n";
+            }
+            errors += current.message;
+            valid = false;
+        }
+    }
+    return valid;
+}
@@ -0,0 +1,37 @@
+#include "default_value.h"
+
+#include <mutex>
+#include <utility>
+
+struct cclip::default_value::lazy_state
+{
+    std::once_flag once;
+};
+
+CCLIP_INLINE cclip::default_value::default_value(const char *value, const int choice_value) : value(value), label(value), choice_value(choice_value), state(nullptr)
+{
+}
+
+CCLIP_INLINE cclip::default_value::default_value(callback<std::string()> compute, const char *label) : value(nullptr), compute(std::move(compute)), label(label), choice_value(-1), state(new lazy_state())
+{
+}
+
+CCLIP_INLINE cclip::default_value::~default_value()
+{
+    delete this->state;
+}
+
+CCLIP_INLINE const char *cclip::default_value::get() const
+{
+    if (this->value != nullptr)
+    {
+        return this->value;
+    }
+    std::call_once(this->state->once, [this] { this->computed = this->compute(); });
+    return this->computed.c_str();
+}
+
+CCLIP_INLINE const char *cclip::default_value::get_label() const
+{
+    return this->label;
+}
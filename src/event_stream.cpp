@@ -0,0 +1,78 @@
+#include "event_stream.h"
+#include "options_manager.h"
+
+CCLIP_INLINE cclip::event_stream::event_stream(const options_manager &schema, const int argc, const char *const *argv) : schema(schema), argc(argc), argv(argv), position(1), terminated(false)
+{
+}
+
+CCLIP_INLINE bool cclip::event_stream::next(parse_event &event)
+{
+    while (this->position < this->argc)
+    {
+        const char *arg = this->argv[this->position++];
+        event = parse_event();
+        const std::int32_t id = this->terminated ? -1 : this->schema.classify(arg);
+        if (id == -1)
+        {
+            event.value = arg;
+            if (this->schema.utf8_validation && !is_valid_utf8(event.value))
+            {
+                event.kind = event_kind::error;
+                event.error = event_error::invalid_utf8;
+            }
+            return true;
+        }
+        if (id == -3)
+        {
+            this->terminated = true; // everything after -- is an operand
+            continue;
+        }
+
+        event.name = arg;
+        if (id == -2)
+        {
+            event.kind = event_kind::error;
+            event.error = event_error::unknown_option;
+            return true;
+        }
+        const option *opt = this->schema.options[id];
+        event.kind = event_kind::option;
+        event.option = option_handle{opt->index};
+        if (!opt->has_argument)
+        {
+            return true;
+        }
+        if (this->position >= this->argc)
+        {
+            event.kind = event_kind::error;
+            event.error = event_error::missing_argument;
+            return true;
+        }
+        const char *argument = this->argv[this->position++];
+        event.value = argument;
+        if (this->schema.utf8_validation && !is_valid_utf8(event.value))
+        {
+            event.kind = event_kind::error;
+            event.error = event_error::invalid_utf8;
+            return true;
+        }
+        if (opt->choices != nullptr)
+        {
+            const choice *match = opt->choices->find(argument);
+            if (match == nullptr)
+            {
+                event.kind = event_kind::error;
+                event.error = event_error::invalid_value;
+                return true;
+            }
+            event.choice_value = match->value;
+        }
+        return true;
+    }
+    return false;
+}
+
+CCLIP_INLINE cclip::event_stream cclip::events(const options_manager &schema, const int argc, const char *const *argv)
+{
+    return event_stream(schema, argc, argv);
+}
@@ -0,0 +1,331 @@
+#include "incremental_parser.h"
+#include "options_manager.h"
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <string_view>
+
+CCLIP_INLINE cclip::incremental_parser::incremental_parser(const options_manager &schema) : schema(schema), gap_begin(0), gap_end(0), counts(schema.get_options().size(), 0), presence((schema.get_options().size() + 63) / 64, 0), error_count(0), missing_required(0), before_requires_present(0), operand_count(0), min_operands(0), max_operands(std::numeric_limits<size_t>::max())
+{
+    for (const auto &option: this->schema.get_options())
+    {
+        this->missing_required += option->is_required;
+    }
+    const auto &positionals = this->schema.get_positionals();
+    for (size_t i = 0; i < positionals.size(); ++i)
+    {
+        if (positionals[i].is_required)
+        {
+            this->min_operands = i + 1;
+        }
+    }
+    if (!positionals.empty() && !positionals.back().is_variadic)
+    {
+        this->max_operands = positionals.size();
+    }
+}
+
+CCLIP_INLINE void cclip::incremental_parser::set_line(const std::string &line)
+{
+    this->edit(0, this->line.size(), line);
+}
+
+CCLIP_INLINE void cclip::incremental_parser::edit(size_t offset, size_t erase_count, const std::string &insert)
+{
+    offset = std::min(offset, this->line.size());
+    erase_count = std::min(erase_count, this->line.size() - offset);
+    const size_t erase_end = offset + erase_count;
+
+    // The tokens touching the edit are replaced; a token ending at the offset or starting right after the erased text may grow
+    const size_t token_count = this->get_token_count();
+    size_t first = 0;
+    for (size_t high = token_count; first < high;)
+    {
+        const size_t middle = first + (high - first) / 2;
+        if (this->begin_of(middle) + this->stored(middle).length < offset)
+            first = middle + 1;
+        else
+            high = middle;
+    }
+    size_t last = first;
+    for (size_t high = token_count; last < high;)
+    {
+        const size_t middle = last + (high - last) / 2;
+        if (this->begin_of(middle) <= erase_end)
+            last = middle + 1;
+        else
+            high = middle;
+    }
+
+    const size_t region_begin = first < last ? std::min(this->begin_of(first), offset) : offset;
+    const size_t region_end = first < last ? std::max(this->begin_of(last - 1) + this->stored(last - 1).length, erase_end) : erase_end;
+
+    // The token before the edit may change from missing its argument to having one, so it is re-classified as well
+    const size_t recount_begin = first > 0 ? first - 1 : 0;
+    for (size_t i = recount_begin; i < last; ++i)
+    {
+        this->count(this->stored(i), -1);
+    }
+
+    // Open the gap where the replaced tokens were, the tokens behind it are measured from the end of the line and keep their offsets
+    this->move_gap(last);
+    this->gap_begin = first;
+    this->line.replace(offset, erase_count, insert);
+    const std::ptrdiff_t delta = static_cast<std::ptrdiff_t>(insert.size()) - static_cast<std::ptrdiff_t>(erase_count);
+
+    std::vector<token> replacement;
+    this->tokenize(region_begin, region_end + delta, replacement);
+    if (this->gap_end - this->gap_begin < replacement.size())
+    {
+        const size_t extra = std::max(replacement.size(), this->tokens.size());
+        this->tokens.insert(this->tokens.begin() + static_cast<std::ptrdiff_t>(this->gap_end), extra, token{});
+        this->gap_end += extra;
+    }
+    std::copy(replacement.begin(), replacement.end(), this->tokens.begin() + static_cast<std::ptrdiff_t>(this->gap_begin));
+    this->gap_begin += replacement.size();
+
+    // Re-classify until an untouched token keeps the classification it had before
+    const size_t replaced_end = first + replacement.size();
+    const size_t new_count = this->get_token_count();
+    for (size_t i = recount_begin; i < new_count; ++i)
+    {
+        token &t = this->stored(i);
+        std::int32_t option;
+        const token_kind kind = this->classify(i, option);
+        if (i >= replaced_end)
+        {
+            if (kind == t.kind && option == t.option)
+            {
+                break;
+            }
+            this->count(t, -1);
+        }
+        t.kind = kind;
+        t.option = option;
+        this->count(t, 1);
+    }
+}
+
+CCLIP_INLINE cclip::incremental_parser::token &cclip::incremental_parser::stored(const size_t index)
+{
+    return this->tokens[index < this->gap_begin ? index : index + (this->gap_end - this->gap_begin)];
+}
+
+CCLIP_INLINE size_t cclip::incremental_parser::begin_of(const size_t index) const
+{
+    return index < this->gap_begin ? this->tokens[index].begin : this->line.size() - this->tokens[index + (this->gap_end - this->gap_begin)].begin;
+}
+
+CCLIP_INLINE void cclip::incremental_parser::move_gap(const size_t index)
+{
+    // Tokens crossing the gap switch between being measured from the start and from the end of the line
+    const size_t size = this->line.size();
+    while (this->gap_begin > index)
+    {
+        token &t = this->tokens[--this->gap_end] = this->tokens[--this->gap_begin];
+        t.begin = size - t.begin;
+    }
+    while (this->gap_begin < index)
+    {
+        token &t = this->tokens[this->gap_begin++] = this->tokens[this->gap_end++];
+        t.begin = size - t.begin;
+    }
+}
+
+CCLIP_INLINE void cclip::incremental_parser::tokenize(size_t begin, const size_t end, std::vector<token> &out) const
+{
+    while (begin < end)
+    {
+        while (begin < end && std::isspace(static_cast<unsigned char>(this->line[begin])))
+        {
+            ++begin;
+        }
+        size_t token_end = begin;
+        while (token_end < end && !std::isspace(static_cast<unsigned char>(this->line[token_end])))
+        {
+            ++token_end;
+        }
+        if (token_end > begin)
+        {
+            out.push_back(token{begin, token_end - begin, token_kind::operand, -1});
+        }
+        begin = token_end;
+    }
+}
+
+CCLIP_INLINE cclip::incremental_parser::token_kind cclip::incremental_parser::classify(const size_t index, std::int32_t &option) const
+{
+    const token t = this->get_token(index);
+    const std::string_view text(this->line.data() + t.begin, t.length);
+    const auto &options = this->schema.get_options();
+    option = -1;
+    if (index > 0)
+    {
+        const token previous = this->get_token(index - 1);
+        if (previous.kind == token_kind::option && options[previous.option]->has_argument)
+        {
+            option = previous.option;
+            if (this->schema.utf8_validation && !is_valid_utf8(text))
+            {
+                return token_kind::invalid_utf8;
+            }
+            const choice_table *choices = options[option]->choices;
+            return choices != nullptr && choices->find(text) == nullptr ? token_kind::invalid_value : token_kind::argument;
+        }
+        if (previous.kind == token_kind::terminator || previous.kind == token_kind::literal || previous.kind == token_kind::invalid_utf8_literal)
+        {
+            return this->schema.utf8_validation && !is_valid_utf8(text) ? token_kind::invalid_utf8_literal : token_kind::literal;
+        }
+    }
+    if (text[0] != '-' || t.length == 1)
+    {
+        return this->schema.utf8_validation && !is_valid_utf8(text) ? token_kind::invalid_utf8 : token_kind::operand;
+    }
+    if (t.length == 2 && text[1] == '-')
+    {
+        return token_kind::terminator;
+    }
+    const bool is_long = t.length > 1 && text[1] == '-';
+    const cclip::option *opt = this->schema.find_option(text.substr(is_long ? 2 : 1));
+    if (opt == nullptr)
+    {
+        return token_kind::unknown_option;
+    }
+    option = static_cast<std::int32_t>(opt->index);
+    return opt->has_argument && index + 1 == this->get_token_count() ? token_kind::missing_argument : token_kind::option;
+}
+
+CCLIP_INLINE void cclip::incremental_parser::count(const token &t, const int direction)
+{
+    switch (t.kind)
+    {
+        case token_kind::option:
+        {
+            const option *opt = this->schema.get_options()[t.option];
+            std::uint32_t &occurrences = this->counts[t.option];
+            const bool was_present = occurrences > 0;
+            occurrences += direction;
+            if (was_present != (occurrences > 0))
+            {
+                const int change = occurrences > 0 ? 1 : -1;
+                this->missing_required -= opt->is_required ? change : 0;
+                this->before_requires_present += opt->executes_before_requires ? change : 0;
+                this->presence[t.option / 64] ^= std::uint64_t{1} << t.option % 64;
+            }
+            break;
+        }
+        case token_kind::operand:
+        case token_kind::literal:
+            this->operand_count += direction;
+            break;
+        case token_kind::unknown_option:
+        case token_kind::missing_argument:
+        case token_kind::invalid_value:
+        case token_kind::invalid_utf8:
+        case token_kind::invalid_utf8_literal:
+            this->error_count += direction;
+            break;
+        default:
+            break;
+    }
+}
+
+CCLIP_INLINE const std::string &cclip::incremental_parser::get_line() const
+{
+    return this->line;
+}
+
+CCLIP_INLINE size_t cclip::incremental_parser::get_token_count() const
+{
+    return this->tokens.size() - (this->gap_end - this->gap_begin);
+}
+
+CCLIP_INLINE cclip::incremental_parser::token cclip::incremental_parser::get_token(const size_t index) const
+{
+    if (index < this->gap_begin)
+    {
+        return this->tokens[index];
+    }
+    token t = this->tokens[index + (this->gap_end - this->gap_begin)];
+    t.begin = this->line.size() - t.begin;
+    return t;
+}
+
+CCLIP_INLINE std::vector<cclip::incremental_parser::token> cclip::incremental_parser::get_tokens() const
+{
+    std::vector<token> result;
+    result.reserve(this->get_token_count());
+    for (size_t i = 0; i < this->get_token_count(); ++i)
+    {
+        result.push_back(this->get_token(i));
+    }
+    return result;
+}
+
+CCLIP_INLINE std::string cclip::incremental_parser::describe(const token &t) const
+{
+    const std::string text = this->line.substr(t.begin, t.length);
+    switch (t.kind)
+    {
+        case token_kind::unknown_option:
+            return "Unknown option: " + text;
+        case token_kind::missing_argument:
+            return "Missing argument for option: " + text.substr(text.find_first_not_of('-'));
+        case token_kind::invalid_value:
+        {
+            const option *opt = this->schema.get_options()[t.option];
+            return "Invalid value for option: " + std::string(opt->long_name[0] ? opt->long_name : opt->short_name) + " (" + text + ")";
+        }
+        case token_kind::invalid_utf8:
+        case token_kind::invalid_utf8_literal:
+        {
+            if (t.option != -1)
+            {
+                const option *opt = this->schema.get_options()[t.option];
+                return "Invalid UTF-8 in the argument of option: " + std::string(opt->long_name[0] ? opt->long_name : opt->short_name);
+            }
+            // parse numbers the argument by its position in argv, which is one past the token's
+            size_t index = 0;
+            for (size_t high = this->get_token_count(); index < high;)
+            {
+                const size_t middle = index + (high - index) / 2;
+                if (this->begin_of(middle) < t.begin)
+                    index = middle + 1;
+                else
+                    high = middle;
+            }
+            return "Invalid UTF-8 in argument " + std::to_string(index + 1);
+        }
+        default:
+            return "";
+    }
+}
+
+CCLIP_INLINE size_t cclip::incremental_parser::get_error_count() const
+{
+    return this->error_count;
+}
+
+CCLIP_INLINE bool cclip::incremental_parser::is_present(const option_handle handle) const
+{
+    return handle.index < this->counts.size() && this->counts[handle.index] > 0;
+}
+
+CCLIP_INLINE bool cclip::incremental_parser::is_valid() const
+{
+    if (this->error_count != 0)
+    {
+        return false;
+    }
+    if (this->before_requires_present > 0)
+    {
+        return true;
+    }
+    if (this->missing_required != 0 || this->operand_count < this->min_operands || this->operand_count > this->max_operands)
+    {
+        return false;
+    }
+    std::string errors;
+    return this->schema.constraints.check(this->presence, errors);
+}
@@ -0,0 +1,71 @@
+#include "name_table.h"
+
+CCLIP_INLINE std::uint32_t cclip::name_table::hash(const std::string_view name)
+{
+    // FNV-1a
+    std::uint32_t hash = 2166136261u;
+    for (const char c: name)
+    {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+CCLIP_INLINE void cclip::name_table::grow()
+{
+    std::vector<slot> previous(this->slots.empty() ? 16 : this->slots.size() * 2);
+    previous.swap(this->slots);
+    const size_t mask = this->slots.size() - 1;
+    for (const slot &entry: previous)
+    {
+        if (entry.name.empty())
+        {
+            continue;
+        }
+        size_t position = hash(entry.name) & mask;
+        while (!this->slots[position].name.empty())
+        {
+            position = (position + 1) & mask;
+        }
+        this->slots[position] = entry;
+    }
+}
+
+CCLIP_INLINE bool cclip::name_table::insert(const std::string_view name, const std::uint32_t index)
+{
+    // Keep the table at most half full so probe sequences stay short
+    if ((this->count + 1) * 2 > this->slots.size())
+    {
+        this->grow();
+    }
+    const size_t mask = this->slots.size() - 1;
+    size_t position = hash(name) & mask;
+    while (!this->slots[position].name.empty())
+    {
+        if (this->slots[position].name == name)
+        {
+            return false;
+        }
+        position = (position + 1) & mask;
+    }
+    this->slots[position] = slot{name, index};
+    ++this->count;
+    return true;
+}
+
+CCLIP_INLINE std::int32_t cclip::name_table::find(const std::string_view name) const
+{
+    if (this->slots.empty() || name.empty())
+    {
+        return -1;
+    }
+    const size_t mask = this->slots.size() - 1;
+    for (size_t position = hash(name) & mask; !this->slots[position].name.empty(); position = (position + 1) & mask)
+    {
+        if (this->slots[position].name == name)
+        {
+            return static_cast<std::int32_t>(this->slots[position].index);
+        }
+    }
+    return -1;
+}
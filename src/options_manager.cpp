@@ -1,31 +1,57 @@
 #include "options_manager.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <filesystem>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
 
-inline cclip::options_manager::options_manager(const char *context, const char *description)
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+CCLIP_INLINE cclip::options_manager::options_manager(const char *context, const char *description)
 {
     this->context = context;
     this->description = description;
     this->version = nullptr;
+    this->parallel_threshold = 65536;
+    this->utf8_validation = false;
+    this->help_width = 0;
+    this->label_column = 0;
 }
 
-inline void cclip::options_manager::add_example_usage(const char *example_usage)
+CCLIP_INLINE cclip::options_manager::~options_manager()
+{
+    for (const option *opt: this->options)
+    {
+        delete opt->choices;
+        delete opt->defaults;
+        delete opt;
+    }
+}
+
+CCLIP_INLINE void cclip::options_manager::add_example_usage(const char *example_usage)
 {
     this->example_usages.push_back(example_usage);
 }
 
-inline void cclip::options_manager::set_version(const char *version)
+CCLIP_INLINE void cclip::options_manager::set_version(const char *version)
 {
     this->version = version;
 }
 
-inline const char *cclip::options_manager::get_version()
+CCLIP_INLINE const char *cclip::options_manager::get_version()
 {
     return this->version;
 }
 
-inline void cclip::options_manager::print_version() const
+CCLIP_INLINE void cclip::options_manager::print_version() const
 {
     if (this->version != nullptr)
     {
@@ -45,7 +71,7 @@ inline void cclip::options_manager::print_version() const
     }
 }
 
-inline void cclip::options_manager::print_examples() const
+CCLIP_INLINE void cclip::options_manager::print_examples() const
 {
     std::cout <<
 #ifdef ANSIConsoleColors
@@ -68,117 +94,473 @@ inline void cclip::options_manager::print_examples() const
 #endif
 }
 
-inline cclip::option *cclip::options_manager::add_option(const char *short_name, const char *long_name, const char *description, const bool is_required, const bool has_argument, const bool executes_before_requires)
+CCLIP_INLINE cclip::option_handle cclip::options_manager::add_option(const char *short_name, const char *long_name, const char *description, const bool is_required, const bool has_argument, const bool executes_before_requires)
 {
     auto *opt = new option{short_name, long_name, description, is_required, has_argument, executes_before_requires, nullptr};
+    opt->index = static_cast<std::uint32_t>(this->options.size());
     this->options.push_back(opt);
-    return opt;
+    this->handlers.emplace_back();
+    if (short_name[0])
+    {
+        this->names.insert(short_name, opt->index);
+        this->suggestions.add(short_name, opt->index, false);
+    }
+    if (long_name[0])
+    {
+        this->names.insert(long_name, opt->index);
+        this->suggestions.add(long_name, opt->index, true);
+    }
+    this->measure_option(opt->index);
+    return option_handle{opt->index};
 }
 
-inline void cclip::options_manager::parse(const int argc, char **argv)
+CCLIP_INLINE cclip::option_handle cclip::options_manager::add_choice_option(const char *short_name, const char *long_name, const char *description, const bool is_required, const std::initializer_list<choice> choices)
 {
-    this->command_name = std::filesystem::path(argv[0]).stem().string(); // Get the executable name
-    for (int i = 0; i < argc; ++i)
+    return this->add_choice_option(short_name, long_name, description, is_required, std::vector<choice>(choices));
+}
+
+CCLIP_INLINE cclip::option_handle cclip::options_manager::add_choice_option(const char *short_name, const char *long_name, const char *description, const bool is_required, std::vector<choice> choices)
+{
+    const option_handle handle = this->add_option(short_name, long_name, description, is_required, true);
+    this->options[handle.index]->choices = new choice_table(std::move(choices));
+    this->measure_option(handle.index);
+    return handle;
+}
+
+CCLIP_INLINE cclip::option_handle cclip::options_manager::add_choice_option(const char *short_name, const char *long_name, const char *description, const bool is_required, const std::initializer_list<const char *> choices)
+{
+    std::vector<choice> indexed;
+    for (const char *value: choices)
     {
-        if (const char *arg = argv[i]; arg[0] == '-')
+        indexed.emplace_back(value, indexed.size());
+    }
+    return this->add_choice_option(short_name, long_name, description, is_required, std::move(indexed));
+}
+
+CCLIP_INLINE cclip::positional_handle cclip::options_manager::add_positional(const char *name, const char *description, const bool is_required)
+{
+    if (!this->positionals.empty() && this->positionals.back().is_variadic)
+    {
+        throw std::logic_error("Positional arguments must be added before the variadic argument.");
+    }
+    this->positionals.push_back(positional{name, description, is_required, false});
+    this->measure_positionals();
+    return positional_handle{static_cast<std::uint32_t>(this->positionals.size() - 1)};
+}
+
+CCLIP_INLINE void cclip::options_manager::set_variadic(const char *name, const char *description, const bool is_required)
+{
+    if (!this->positionals.empty() && this->positionals.back().is_variadic)
+    {
+        this->positionals.pop_back();
+    }
+    this->positionals.push_back(positional{name, description, is_required, true});
+    this->measure_positionals();
+}
+
+CCLIP_INLINE const char *cclip::options_manager::get(const positional_handle handle) const
+{
+    const operand_span operands = this->result.get_operands();
+    return handle.index < operands.size() ? operands[handle.index] : nullptr;
+}
+
+CCLIP_INLINE cclip::operand_span cclip::options_manager::get_operands() const
+{
+    return this->result.get_operands();
+}
+
+CCLIP_INLINE cclip::operand_span cclip::options_manager::get_variadic() const
+{
+    const size_t named = this->positionals.empty() || !this->positionals.back().is_variadic ? this->positionals.size() : this->positionals.size() - 1;
+    return this->result.get_operands().subspan(named);
+}
+
+CCLIP_INLINE const std::vector<cclip::positional> &cclip::options_manager::get_positionals() const
+{
+    return this->positionals;
+}
+
+CCLIP_INLINE void cclip::options_manager::set_default(const option_handle handle, const char *value)
+{
+    if (handle.index >= this->options.size())
+    {
+        throw std::invalid_argument("Default value refers to an option that does not exist.");
+    }
+    if (value == nullptr)
+    {
+        throw std::invalid_argument("Default value must not be null.");
+    }
+    option *opt = this->options[handle.index];
+    if (!opt->has_argument)
+    {
+        throw std::logic_error("Only options with an argument can have a default value.");
+    }
+    int choice_value = -1;
+    if (opt->choices != nullptr)
+    {
+        const choice *match = opt->choices->find(value);
+        if (match == nullptr)
+        {
+            throw std::invalid_argument("Default value is not one of the choices: " + std::string(value));
+        }
+        choice_value = match->value;
+    }
+    delete opt->defaults;
+    opt->defaults = new default_value(value, choice_value);
+}
+
+CCLIP_INLINE void cclip::options_manager::set_default(const option_handle handle, callback<std::string()> compute, const char *label)
+{
+    if (handle.index >= this->options.size())
+    {
+        throw std::invalid_argument("Default value refers to an option that does not exist.");
+    }
+    if (!compute)
+    {
+        throw std::invalid_argument("Computed default value must not be empty.");
+    }
+    option *opt = this->options[handle.index];
+    if (!opt->has_argument)
+    {
+        throw std::logic_error("Only options with an argument can have a default value.");
+    }
+    if (opt->choices != nullptr)
+    {
+        throw std::logic_error("Choice options need a fixed default value, one of their choices.");
+    }
+    delete opt->defaults;
+    opt->defaults = new default_value(std::move(compute), label);
+}
+
+CCLIP_INLINE const char *cclip::options_manager::get_or_default(const option_handle handle) const
+{
+    return this->get_or_default(this->result, handle);
+}
+
+CCLIP_INLINE const char *cclip::options_manager::get_or_default(const parse_result &result, const option_handle handle) const
+{
+    const char *argument = result.get(handle);
+    if (argument != nullptr || handle.index >= this->options.size() || this->options[handle.index]->defaults == nullptr)
+    {
+        return argument;
+    }
+    return this->options[handle.index]->defaults->get();
+}
+
+CCLIP_INLINE std::string cclip::options_manager::display_names(const std::initializer_list<option_handle> handles) const
+{
+    std::string names;
+    for (const option_handle handle: handles)
+    {
+        if (handle.index >= this->options.size())
         {
-            if (arg[1] == '-')
+            throw std::invalid_argument("Constraint refers to an option that does not exist.");
+        }
+        const option *opt = this->options[handle.index];
+        if (!names.empty())
+        {
+            names += ", ";
+        }
+        names += opt->long_name[0] ? "--" + std::string(opt->long_name) : "-" + std::string(opt->short_name);
+    }
+    return names;
+}
+
+CCLIP_INLINE void cclip::options_manager::add_requires(const option_handle handle, const std::initializer_list<option_handle> required)
+{
+    const std::string message = "Option " + this->display_names({handle}) + " requires " + this->display_names(required);
+    std::vector<std::uint32_t> group;
+    for (const option_handle other: required)
+    {
+        group.push_back(other.index);
+    }
+    const auto count = static_cast<std::uint32_t>(group.size());
+    this->constraints.add({handle.index}, group, count, count, message);
+}
+
+CCLIP_INLINE void cclip::options_manager::add_conflicts(const option_handle handle, const std::initializer_list<option_handle> conflicting)
+{
+    const std::string message = "Option " + this->display_names({handle}) + " conflicts with " + this->display_names(conflicting);
+    std::vector<std::uint32_t> group;
+    for (const option_handle other: conflicting)
+    {
+        group.push_back(other.index);
+    }
+    this->constraints.add({handle.index}, group, 0, 0, message);
+}
+
+CCLIP_INLINE void cclip::options_manager::add_one_of(const std::initializer_list<option_handle> group)
+{
+    const std::string message = "Exactly one of these options must be given: " + this->display_names(group);
+    std::vector<std::uint32_t> indices;
+    for (const option_handle handle: group)
+    {
+        indices.push_back(handle.index);
+    }
+    this->constraints.add({}, indices, 1, 1, message);
+}
+
+CCLIP_INLINE void cclip::options_manager::add_any_of(const std::initializer_list<option_handle> group)
+{
+    const std::string message = "At least one of these options must be given: " + this->display_names(group);
+    std::vector<std::uint32_t> indices;
+    for (const option_handle handle: group)
+    {
+        indices.push_back(handle.index);
+    }
+    this->constraints.add({}, indices, 1, static_cast<std::uint32_t>(indices.size()), message);
+}
+
+CCLIP_INLINE void cclip::options_manager::add_at_most_one_of(const std::initializer_list<option_handle> group)
+{
+    const std::string message = "At most one of these options can be given: " + this->display_names(group);
+    std::vector<std::uint32_t> indices;
+    for (const option_handle handle: group)
+    {
+        indices.push_back(handle.index);
+    }
+    this->constraints.add({}, indices, 0, 1, message);
+}
+
+CCLIP_INLINE void cclip::options_manager::on(const option_handle handle, callback<void(const char *argument)> handler)
+{
+    if (handle.index >= this->handlers.size())
+    {
+        throw std::invalid_argument("Handler refers to an option that does not exist.");
+    }
+    this->handlers[handle.index] = std::move(handler);
+}
+
+CCLIP_INLINE void cclip::options_manager::store_argument(const option *opt, const char *name, char *argument, parse_result &result) const
+{
+    if (this->utf8_validation && !is_valid_utf8(argument))
+    {
+        throw parse_error("Invalid UTF-8 in the argument of option: " + std::string(name));
+    }
+    int choice_value = -1;
+    if (opt->choices != nullptr)
+    {
+        const choice *match = opt->choices->find(argument);
+        if (match == nullptr)
+        {
+            std::string message = "Invalid value for option: " + std::string(name) + " (expected one of:";
+            for (const auto &value: opt->choices->get_choices())
             {
-                // long option
-                const char *name = arg + 2;
-                if (option *opt = this->get_option_from_global_list(name); opt == nullptr)
-                {
-#ifdef ANSIConsoleColors
-                        colors::ConsoleColors::SetForegroundColor(colors::ColorCodes::Red);
-#endif
-                    std::cerr << "Unknown option: --" << name << std::endl;
-#ifdef ANSIConsoleColors
-                        colors::ConsoleColors::ResetConsoleColor();
-#endif
-                    this->print_help();
-                    exit(1);
-                } else
-                {
-                    if (opt->has_argument)
-                    {
-                        if (i + 1 >= argc)
-                        {
-#ifdef ANSIConsoleColors
-                                colors::ConsoleColors::SetForegroundColor(colors::ColorCodes::Red);
-#endif
-                            std::cerr << "Missing argument for option: " << name << std::endl;
+                message += " ";
+                message += value.name;
+            }
+            throw parse_error(message + ")");
+        }
+        choice_value = match->value;
+    }
+    result.set(opt->index, argument, choice_value);
+}
 
-#ifdef ANSIConsoleColors
-                                colors::ConsoleColors::ResetConsoleColor();
-#endif
-                            this->print_help();
-                            exit(1);
-                        }
-                        opt->argument = argv[i + 1];
-                    }
-                    this->present_options.push_back(opt);
-                }
-            } else
+CCLIP_INLINE void cclip::options_manager::parse_into(const int argc, char **argv, parse_result &result) const
+{
+    this->parse_arguments(argc, argv, result, false, nullptr, true);
+}
+
+CCLIP_INLINE void cclip::options_manager::parse_into(const int argc, char **argv, parse_result &result, option_sink &sink) const
+{
+    this->parse_arguments(argc, argv, result, false, &sink, true);
+}
+
+CCLIP_INLINE bool cclip::options_manager::parse_arguments(const int argc, char **argv, parse_result &result, const bool dispatch, option_sink *sink, const bool complete) const
+{
+    result.reset(this->options.size());
+
+    // Very long argument lists are classified on several threads first, the loop below only resolves arguments and order
+    std::vector<std::int32_t> classes;
+    if (static_cast<size_t>(argc) > this->parallel_threshold)
+    {
+        classes = this->classify_parallel(argc, argv);
+    }
+
+    // Operands are moved to the front of argv as they are found. The options, option arguments and -- they pass are set aside, and when
+    // the parse ends, even on an error, they are written back and rotated in front of the operands. argv then keeps every entry in the
+    // order getopt leaves it: the program name, the options in the order they were given, then the operands, so it parses the same again
+    std::vector<char *> &displaced = result.displaced;
+    displaced.clear();
+    int operand_end = 1;
+    struct argv_guard
+    {
+        char **argv;
+        const int &operand_end;
+        std::vector<char *> &displaced;
+        bool restored;
+
+        // Returns where the operands start once argv is restored
+        char **restore()
+        {
+            char **operands = this->argv + 1 + this->displaced.size();
+            if (!this->restored)
+            {
+                char **options = std::copy(this->displaced.begin(), this->displaced.end(), this->argv + this->operand_end);
+                std::rotate(this->argv + 1, this->argv + this->operand_end, options);
+                this->displaced.clear();
+                this->restored = true;
+            }
+            return operands;
+        }
+
+        ~argv_guard()
+        {
+            this->restore();
+        }
+    } guard{argv, operand_end, displaced, false};
+    bool terminated = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        char *arg = argv[i];
+        const std::int32_t id = terminated ? -1 : classes.empty() ? this->classify(arg) : classes[i];
+        if (id == -1)
+        {
+            if (this->utf8_validation && !is_valid_utf8(arg))
+            {
+                throw parse_error("Invalid UTF-8 in argument " + std::to_string(i));
+            }
+            argv[operand_end++] = arg;
+            continue;
+        }
+        displaced.push_back(arg);
+        if (id == -3)
+        {
+            terminated = true; // everything after -- is an operand
+            continue;
+        }
+
+        // long options are prefixed with two dashes, short options with one
+        const bool is_long = arg[1] == '-';
+        const char *name = arg + (is_long ? 2 : 1);
+        if (id == -2)
+        {
+            std::string message = std::string("Unknown option: ") + (is_long ? "--" : "-") + name;
+            std::vector<std::string> names;
+            for (const suggestion &match: this->suggestions.find(name))
+            {
+                names.push_back((match.is_long ? "--" : "-") + std::string(match.name));
+            }
+            for (size_t n = 0; n < names.size(); ++n)
+            {
+                message += n == 0 ? (names.size() == 1 ? "\nDid you mean " : "\nDid you mean one of: ") : ", ";
+                message += names[n];
+            }
+            if (!names.empty())
+            {
+                message += "?";
+            }
+            throw unknown_option_error(message, std::move(names));
+        }
+        const option *opt = this->options[id];
+        if (opt->has_argument)
+        {
+            if (i + 1 >= argc)
+            {
+                throw parse_error("Missing argument for option: " + std::string(name));
+            }
+            char *argument = argv[++i];
+            displaced.push_back(argument);
+            this->store_argument(opt, name, argument, result);
+        }
+        result.set(opt->index);
+        if (sink != nullptr)
+        {
+            sink->accept(option_handle{opt->index}, result.get({opt->index}), result.get_choice_value({opt->index}));
+        }
+        if (dispatch && this->handlers[opt->index])
+        {
+            this->handlers[opt->index](result.get({opt->index}));
+            if (opt->executes_before_requires)
             {
-                // short option
-                const char *name = arg + 1;
-                if (option *opt = this->get_option_from_global_list(name); opt == nullptr)
-                {
-                    std::cerr << "Unknown option: -" << name << std::endl;
-                    this->print_help();
-                    exit(1);
-                } else
-                {
-                    if (opt->has_argument)
-                    {
-                        if (i + 1 >= argc)
-                        {
-                            std::cerr << "Missing argument for option: " << name << std::endl;
-                            this->print_help();
-                            exit(1);
-                        }
-                        opt->argument = argv[i + 1];
-                    }
-                    this->present_options.push_back(opt);
-                }
+                result.set_operands(operand_span(guard.restore(), static_cast<size_t>(operand_end - 1)));
+                return false;
             }
         }
     }
-    bool ignore_missing = false;
+    const operand_span operands(guard.restore(), static_cast<size_t>(operand_end - 1));
+    result.set_operands(operands);
+    if (!complete)
+    {
+        return true;
+    }
+
+    for (const auto &option: this->options)
+    {
+        if (option->executes_before_requires && result.is_present({option->index}))
+        {
+            return true;
+        }
+    }
+    std::string missing;
     for (const auto &option: this->options)
     {
-        if (option->executes_before_requires && this->is_present(option->short_name))
+        if (option->is_required && !result.is_present({option->index}))
         {
-            ignore_missing = true;
-            break;
+            if (!missing.empty())
+            {
+                missing += "\n";
+            }
+            missing += "Missing required option: -" + std::string(option->short_name) + " or --" + option->long_name;
         }
     }
-    if (!ignore_missing)
+    for (size_t i = 0; i < this->positionals.size(); ++i)
     {
-        bool missing = false;
-        for (const auto &option: this->options)
+        const positional &slot = this->positionals[i];
+        if (slot.is_required && operands.size() <= i)
         {
-            if (option->is_required && !this->is_present(option->short_name))
+            if (!missing.empty())
             {
+                missing += "\n";
+            }
+            missing += "Missing required argument: " + std::string(slot.name);
+        }
+    }
+    this->constraints.check(result.get_presence(), missing);
+    if (!missing.empty())
+    {
+        throw parse_error(missing);
+    }
+    if (!this->positionals.empty() && !this->positionals.back().is_variadic && operands.size() > this->positionals.size())
+    {
+        throw parse_error("Unexpected argument: " + std::string(operands[this->positionals.size()]));
+    }
+    return true;
+}
+
+CCLIP_INLINE bool cclip::options_manager::parse(const int argc, char **argv)
+{
+    this->command_name = std::filesystem::path(argv[0]).stem().string(); // Get the executable name
+    bool finished = true;
+    try
+    {
+        finished = this->parse_arguments(argc, argv, this->result, true, nullptr, true);
+    } catch (const parse_error &e)
+    {
 #ifdef ANSIConsoleColors
-                colors::ConsoleColors::SetForegroundColor(colors::ColorCodes::Red);
+        colors::ConsoleColors::SetForegroundColor(colors::ColorCodes::Red);
 #endif
-                std::cerr << "Missing required option: -" << option->short_name << " or --" << option->long_name << std::endl;
+        std::cerr << e.what() << std::endl;
 #ifdef ANSIConsoleColors
-                colors::ConsoleColors::ResetConsoleColor();
+        colors::ConsoleColors::ResetConsoleColor();
 #endif
-                missing = true;
-            }
-        }
-        if (missing)
+        // A suggestion is more useful than the full help, which can be very long
+        const auto *unknown = dynamic_cast<const unknown_option_error *>(&e);
+        if (unknown == nullptr || unknown->get_suggestions().empty())
         {
             this->print_help();
-            exit(1);
         }
+        exit(1);
+    }
+    for (const auto &option: this->options)
+    {
+        option->argument = this->result.get({option->index});
+        option->choice_value = this->result.get_choice_value({option->index});
     }
+    return finished;
 }
 
-inline void cclip::options_manager::print_help(const bool print_examples) const
+CCLIP_INLINE void cclip::options_manager::print_help(const bool print_examples) const
 {
     const char *help = this->get_help();
     if (print_examples)
@@ -190,7 +572,149 @@ inline void cclip::options_manager::print_help(const bool print_examples) const
 }
 
 
-inline const char *cclip::options_manager::get_help() const
+CCLIP_INLINE std::string cclip::options_manager::help_label(const option &opt)
+{
+    std::string label;
+    if (opt.short_name[0])
+    {
+        label += "-";
+        label += opt.short_name;
+        if (opt.long_name[0])
+        {
+            label += ", ";
+        }
+    }
+    if (opt.long_name[0])
+    {
+        label += "--";
+        label += opt.long_name;
+    }
+    if (opt.choices != nullptr)
+    {
+        label += " <";
+        const auto &values = opt.choices->get_choices();
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            label += i ? "|" : "";
+            label += values[i].name;
+        }
+        label += ">";
+    } else if (opt.has_argument)
+    {
+        label += " <arg>";
+    }
+    return label;
+}
+
+CCLIP_INLINE std::string cclip::options_manager::help_label(const positional &slot)
+{
+    return "<" + std::string(slot.name) + ">" + (slot.is_variadic ? "..." : "");
+}
+
+CCLIP_INLINE void cclip::options_manager::measure_option(const std::uint32_t index)
+{
+    if (this->option_label_widths.size() <= index)
+    {
+        this->option_label_widths.resize(index + 1, 0);
+    }
+    this->option_label_widths[index] = display_width(help_label(*this->options[index]));
+    this->label_column = std::max(this->label_column, this->option_label_widths[index]);
+}
+
+CCLIP_INLINE void cclip::options_manager::measure_positionals()
+{
+    // The variadic argument can be replaced, so the column is measured again from every label
+    this->positional_label_widths.clear();
+    this->label_column = 0;
+    for (const positional &slot: this->positionals)
+    {
+        this->positional_label_widths.push_back(display_width(help_label(slot)));
+        this->label_column = std::max(this->label_column, this->positional_label_widths.back());
+    }
+    for (const size_t label_width: this->option_label_widths)
+    {
+        this->label_column = std::max(this->label_column, label_width);
+    }
+}
+
+CCLIP_INLINE void cclip::options_manager::align_help_column(std::ostream &out, size_t &cursor, const size_t column, const size_t indent)
+{
+    // Labels wider than the column get their description on the next line
+    if (cursor > column)
+    {
+        out << "\n";
+        cursor = 0;
+    }
+    out << std::string(indent - cursor, ' ');
+    cursor = indent;
+}
+
+CCLIP_INLINE void cclip::options_manager::append_wrapped(std::ostream &out, const std::string_view text, size_t &cursor, const size_t indent, const size_t width)
+{
+    size_t start = 0;
+    while (start < text.size())
+    {
+        size_t end = text.find_first_of(" \n", start);
+        if (end == std::string_view::npos)
+        {
+            end = text.size();
+        }
+        const std::string_view word = text.substr(start, end - start);
+        if (!word.empty())
+        {
+            const size_t word_width = display_width(word);
+            if (cursor > indent && cursor + 1 + word_width > width)
+            {
+                out << "\n" << std::string(indent, ' ');
+                cursor = indent;
+            } else if (cursor > indent)
+            {
+                out << ' ';
+                ++cursor;
+            }
+            out << word;
+            cursor += word_width;
+        }
+        if (end < text.size() && text[end] == '\n')
+        {
+            out << "\n" << std::string(indent, ' ');
+            cursor = indent;
+        }
+        start = end + 1;
+    }
+}
+
+CCLIP_INLINE size_t cclip::options_manager::terminal_width()
+{
+    if (const char *columns = std::getenv("COLUMNS"); columns != nullptr)
+    {
+        const unsigned long value = std::strtoul(columns, nullptr, 10);
+        if (value > 0)
+        {
+            return value;
+        }
+    }
+#if defined(__unix__) || defined(__APPLE__)
+    winsize size{};
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0)
+    {
+        return size.ws_col;
+    }
+#endif
+    return 80;
+}
+
+CCLIP_INLINE void cclip::options_manager::set_help_width(const size_t columns)
+{
+    this->help_width = columns;
+}
+
+CCLIP_INLINE void cclip::options_manager::set_utf8_validation(const bool enabled)
+{
+    this->utf8_validation = enabled;
+}
+
+CCLIP_INLINE const char *cclip::options_manager::get_help() const
 {
     std::stringstream buf;
     buf <<
@@ -207,6 +731,12 @@ inline const char *cclip::options_manager::get_help() const
                 this->description << "\n";
     }
 
+    // The label column was measured as the options were added, only the descriptions are wrapped to the terminal here
+    const size_t width = this->help_width != 0 ? this->help_width : terminal_width();
+    const size_t column = std::min(this->label_column, width / 2);
+    const size_t indent = column + 2;
+    const size_t text_width = std::max(width, indent + 20);
+
     for (auto &option: this->options)
     {
         if (option->short_name[0])
@@ -229,26 +759,66 @@ inline const char *cclip::options_manager::get_help() const
                     "--" << option->long_name;
         }
 
-        if (option->has_argument)
+        if (option->choices != nullptr)
+        {
+            buf << " <";
+            const auto &values = option->choices->get_choices();
+            for (size_t i = 0; i < values.size(); ++i)
+            {
+                buf << (i ? "|" : "") << values[i].name;
+            }
+            buf << ">";
+        } else if (option->has_argument)
         {
             buf << " <arg>";
         }
+
+        size_t cursor = this->option_label_widths[option->index];
+        align_help_column(buf, cursor, column, indent);
+#ifdef ANSIConsoleColors
+        buf << colors::ConsoleColors::GetColorCode(colors::ColorCodes::LightGray);
+#endif
+        append_wrapped(buf, option->description == nullptr ? "" : option->description, cursor, indent, text_width);
         if (option->is_required)
         {
-            buf <<
 #ifdef ANSIConsoleColors
-                        colors::ConsoleColors::GetColorCode(colors::ColorCodes::Red)
-                        <<
+            buf << colors::ConsoleColors::GetColorCode(colors::ColorCodes::Red);
+#endif
+            append_wrapped(buf, "(required)", cursor, indent, text_width);
+        }
+        if (option->defaults != nullptr && option->defaults->get_label() != nullptr)
+        {
+#ifdef ANSIConsoleColors
+            buf << colors::ConsoleColors::GetColorCode(colors::ColorCodes::LightGray);
 #endif
-                    " (required)";
+            append_wrapped(buf, "(default: " + std::string(option->defaults->get_label()) + ")", cursor, indent, text_width);
         }
+        buf << "\n";
+    }
 
+    for (size_t i = 0; i < this->positionals.size(); ++i)
+    {
+        const positional &slot = this->positionals[i];
         buf <<
 #ifdef ANSIConsoleColors
-                    colors::ConsoleColors::GetColorCode(colors::ColorCodes::LightGray)
-                    <<
+                colors::ConsoleColors::GetColorCode(colors::ColorCodes::Cyan) <<
+#endif
+                "<" << slot.name << ">" << (slot.is_variadic ? "..." : "");
+
+        size_t cursor = this->positional_label_widths[i];
+        align_help_column(buf, cursor, column, indent);
+#ifdef ANSIConsoleColors
+        buf << colors::ConsoleColors::GetColorCode(colors::ColorCodes::LightGray);
+#endif
+        append_wrapped(buf, slot.description == nullptr ? "" : slot.description, cursor, indent, text_width);
+        if (slot.is_required)
+        {
+#ifdef ANSIConsoleColors
+            buf << colors::ConsoleColors::GetColorCode(colors::ColorCodes::Red);
 #endif
-                "\n\t" << option->description << "\n";
+            append_wrapped(buf, "(required)", cursor, indent, text_width);
+        }
+        buf << "\n";
     }
 
 #ifdef ANSIConsoleColors
@@ -261,39 +831,96 @@ inline const char *cclip::options_manager::get_help() const
     return help_str;
 }
 
-inline bool cclip::options_manager::is_present(const std::string &name) const
+CCLIP_INLINE bool cclip::options_manager::is_present(const std::string &name) const
 {
-    return std::any_of(this->present_options.begin(), this->present_options.end(), [&name](const option *opt)
-    {
-        return opt->short_name == name || opt->long_name == name;
-    });
+    const option *opt = this->get_option_from_global_list(name);
+    return opt != nullptr && this->result.is_present({opt->index});
+}
+
+CCLIP_INLINE cclip::option *cclip::options_manager::get_option(const std::string &name)
+{
+    option *opt = this->get_option_from_global_list(name);
+    return opt != nullptr && this->result.is_present({opt->index}) ? opt : nullptr;
 }
 
-inline cclip::option *cclip::options_manager::get_option(const std::string &name)
+CCLIP_INLINE cclip::option *cclip::options_manager::get_option_from_global_list(const std::string &name) const
 {
-    for (const auto &option: this->present_options)
+    const std::int32_t index = this->names.find(name);
+    return index < 0 ? nullptr : this->options[index];
+}
+
+CCLIP_INLINE std::int32_t cclip::options_manager::classify(const char *arg) const
+{
+    // -1 for an operand, -2 for an unknown option, -3 for the -- terminator, otherwise the index of the option
+    if (arg[0] != '-' || arg[1] == '\0') // a lone dash is an operand, usually meaning stdin
     {
-        if (option->short_name == name || option->long_name == name)
-        {
-            return option;
-        }
+        return -1;
     }
-    return nullptr;
+    if (arg[1] == '-' && arg[2] == '\0')
+    {
+        return -3;
+    }
+    const std::int32_t index = this->names.find(std::string_view(arg + (arg[1] == '-' ? 2 : 1)));
+    return index < 0 ? -2 : index;
 }
 
-inline cclip::option *cclip::options_manager::get_option_from_global_list(const std::string &name)
+CCLIP_INLINE std::vector<std::int32_t> cclip::options_manager::classify_parallel(const int argc, char **argv) const
 {
-    for (const auto &option: this->options)
+    const size_t count = argc;
+    const size_t thread_count = std::min<size_t>(std::thread::hardware_concurrency(), count / 4096);
+    if (thread_count < 2)
+    {
+        return {}; // not worth it, classify while resolving instead
+    }
+    std::vector<std::int32_t> classes(argc, -1);
+    const size_t chunk = (count + thread_count - 1) / thread_count;
+
+    std::vector<std::thread> threads;
+    for (size_t begin = 1; begin < count; begin += chunk)
     {
-        if (std::strcmp(option->short_name, name.c_str()) == 0 || std::strcmp(option->long_name, name.c_str()) == 0)
+        const size_t end = std::min(count, begin + chunk);
+        threads.emplace_back([this, argv, &classes, begin, end]
         {
-            return option;
-        }
+            for (size_t i = begin; i < end; ++i)
+            {
+                classes[i] = this->classify(argv[i]);
+            }
+        });
+    }
+    for (auto &thread: threads)
+    {
+        thread.join();
     }
-    return nullptr;
+    return classes;
+}
+
+CCLIP_INLINE void cclip::options_manager::set_parallel_threshold(const size_t threshold)
+{
+    this->parallel_threshold = threshold;
+}
+
+CCLIP_INLINE const cclip::option *cclip::options_manager::find_option(const std::string_view name) const
+{
+    const std::int32_t index = this->names.find(name);
+    return index < 0 ? nullptr : this->options[index];
+}
+
+CCLIP_INLINE std::vector<cclip::suggestion> cclip::options_manager::suggest(const std::string &name, const size_t max_results) const
+{
+    return this->suggestions.find(name, max_results);
+}
+
+CCLIP_INLINE const std::vector<cclip::option *> &cclip::options_manager::get_options() const
+{
+    return this->options;
+}
+
+CCLIP_INLINE const cclip::parse_result &cclip::options_manager::get_result() const
+{
+    return this->result;
 }
 
-char *cclip::options_manager::build_autocomplete_ps1() const
+CCLIP_INLINE char *cclip::options_manager::build_autocomplete_ps1() const
 {
     if (this->command_name.empty())
     {
@@ -319,12 +946,46 @@ char *cclip::options_manager::build_autocomplete_ps1() const
     }
     options = options.substr(0, options.length() - 2); // Remove the trailing comma and space
 
+    // Map every spelling of a choice option to the values it accepts
+    std::string choices;
+    for (const auto &option: this->options)
+    {
+        if (option->choices == nullptr)
+        {
+            continue;
+        }
+        std::string values;
+        for (const auto &value: option->choices->get_choices())
+        {
+            values += "'";
+            values += value.name;
+            values += "', ";
+        }
+        values = values.substr(0, values.length() - 2);
+        if (option->short_name[0])
+        {
+            choices += "'-" + std::string(option->short_name) + "' = @(" + values + "); ";
+        }
+        if (option->long_name[0])
+        {
+            choices += "'--" + std::string(option->long_name) + "' = @(" + values + "); ";
+        }
+    }
+
     std::string ps1 =
             "# " + std::string(this->context) + " command-line autocomplete\n"
-            "Register-ArgumentCompleter -CommandName '" + this->command_name + "' -ScriptBlock {\n"
-            "param($commandName, $wordToComplete, $cursorPosition)\n"
-            "$options = " + options + "\n\n"
-            "$options | Where-Object { $_ -like \"$wordToComplete * \" } | ForEach-Object {\n"
+            "Register-ArgumentCompleter -Native -CommandName '" + this->command_name + "' -ScriptBlock {\n"
+            "param($wordToComplete, $commandAst, $cursorPosition)\n"
+            "$options = " + options + "\n"
+            "$choices = @{ " + choices + "}\n\n"
+            "$previous = $commandAst.CommandElements | Where-Object { $_.Extent.EndOffset -lt $cursorPosition } | Select-Object -Last 1\n"
+            "if ($previous -and $choices.ContainsKey($previous.ToString())) {\n"
+            "$choices[$previous.ToString()] | Where-Object { $_ -like \"$wordToComplete*\" } | ForEach-Object {\n"
+            "[System.Management.Automation.CompletionResult]::new($_, $_, 'ParameterValue', $_)\n"
+            "}\n"
+            "return\n"
+            "}\n"
+            "$options | Where-Object { $_ -like \"$wordToComplete*\" } | ForEach-Object {\n"
             "[System.Management.Automation.CompletionResult]::new($_, $_, 'ParameterName', $_)\n"
             "}\n"
             "}\n";
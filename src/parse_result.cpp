@@ -0,0 +1,24 @@
+#include "parse_result.h"
+
+CCLIP_INLINE void cclip::parse_result::reset(const size_t option_count)
+{
+    this->present.assign((option_count + 63) / 64, 0);
+    this->arguments.assign(option_count, nullptr);
+    this->choice_values.assign(option_count, -1);
+    this->operands = operand_span();
+}
+
+CCLIP_INLINE void cclip::parse_result::set(const std::uint32_t index, char *argument, const int choice_value)
+{
+    this->present[index / 64] |= std::uint64_t{1} << (index % 64);
+    if (argument != nullptr)
+    {
+        this->arguments[index] = argument;
+        this->choice_values[index] = choice_value;
+    }
+}
+
+CCLIP_INLINE void cclip::parse_result::set_operands(const operand_span operands)
+{
+    this->operands = operands;
+}
@@ -0,0 +1,374 @@
+#include "suggestion_index.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+CCLIP_INLINE void cclip::suggestion_index::add(const char *name, const std::uint32_t option, const bool is_long)
+{
+    const size_t length = std::strlen(name);
+    const auto id = static_cast<std::uint32_t>(this->entries.size());
+    const posting added{character_set(name, length), id, static_cast<std::uint32_t>(length)};
+    this->entries.push_back(entry{name, length, option, is_long});
+    if (length >= this->buckets.size())
+    {
+        this->buckets.resize(length + 1);
+    }
+    this->buckets[length].push_back(added);
+    for (size_t i = 0; i + 1 < length; ++i)
+    {
+        if (length <= max_bigram_length)
+        {
+            this->index_gram(gram(name + i, 2), added);
+        }
+        if (i + 2 < length)
+        {
+            this->index_gram(gram(name + i, 3), added);
+        }
+    }
+}
+
+CCLIP_INLINE void cclip::suggestion_index::index_gram(const std::uint32_t key, const posting &added)
+{
+    size_t position = this->find_gram(key);
+    if (position == this->gram_slots.size())
+    {
+        const auto list = static_cast<std::uint32_t>(this->postings.size());
+        this->postings.emplace_back();
+        if (this->postings.size() * 2 > this->gram_slots.size())
+        {
+            std::vector<gram_slot> previous(this->gram_slots.empty() ? 64 : this->gram_slots.size() * 2, gram_slot{0, 0, 0});
+            previous.swap(this->gram_slots);
+            for (const gram_slot &slot: previous)
+            {
+                if (slot.key != 0)
+                {
+                    this->place(slot);
+                }
+            }
+        }
+        this->place(gram_slot{key, list, 0});
+        position = this->find_gram(key);
+    }
+    // Keep the list sorted by length, this entry goes after every name as long as its own, where it already is if the name repeats the gram
+    gram_slot &slot = this->gram_slots[position];
+    std::vector<posting> &list = this->postings[slot.list];
+    const auto insert_at = std::upper_bound(list.begin(), list.end(), added.length, [](const size_t value, const posting &p) { return value < p.length; });
+    if (insert_at == list.begin() || std::prev(insert_at)->entry != added.entry)
+    {
+        list.insert(insert_at, added);
+        slot.size = static_cast<std::uint32_t>(list.size());
+    }
+}
+
+CCLIP_INLINE std::uint32_t cclip::suggestion_index::gram(const char *text, const size_t size)
+{
+    // A bigram is marked above the 24 bits of a trigram, whose first character is never null, so the two never share a key
+    const auto byte = [text](const size_t i) { return static_cast<std::uint32_t>(static_cast<unsigned char>(text[i])); };
+    return size == 2 ? 1u << 24 | byte(0) << 8 | byte(1) : byte(0) << 16 | byte(1) << 8 | byte(2);
+}
+
+CCLIP_INLINE size_t cclip::suggestion_index::home(const std::uint32_t key) const
+{
+    // Fibonacci hashing, folding the well mixed high bits of the product into the low ones
+    const std::uint32_t hash = key * 2654435769u;
+    return (hash ^ hash >> 15) & (this->gram_slots.size() - 1);
+}
+
+CCLIP_INLINE void cclip::suggestion_index::place(const gram_slot &slot)
+{
+    const size_t mask = this->gram_slots.size() - 1;
+    size_t position = this->home(slot.key);
+    while (this->gram_slots[position].key != 0)
+    {
+        position = (position + 1) & mask;
+    }
+    this->gram_slots[position] = slot;
+}
+
+CCLIP_INLINE size_t cclip::suggestion_index::find_gram(const std::uint32_t key) const
+{
+    // The position of the slot, or the size of the table if no name has the gram
+    if (this->gram_slots.empty())
+    {
+        return 0;
+    }
+    const size_t mask = this->gram_slots.size() - 1;
+    for (size_t position = this->home(key); this->gram_slots[position].key != 0; position = (position + 1) & mask)
+    {
+        if (this->gram_slots[position].key == key)
+        {
+            return position;
+        }
+    }
+    return this->gram_slots.size();
+}
+
+CCLIP_INLINE std::uint64_t cclip::suggestion_index::character_set(const char *text, const size_t length)
+{
+    std::uint64_t set = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+        set |= std::uint64_t{1} << (static_cast<unsigned char>(text[i]) & 63);
+    }
+    return set;
+}
+
+
+CCLIP_INLINE size_t cclip::suggestion_index::distance(const unsigned char *slots, const std::uint64_t *peq, const char *pattern, const size_t pattern_length, const char *text, const size_t text_length, const size_t limit)
+{
+    // A common prefix and suffix do not change the distance, and names that share words often differ in a few characters in between
+    size_t prefix = 0;
+    while (prefix < pattern_length && prefix < text_length && pattern[prefix] == text[prefix])
+    {
+        ++prefix;
+    }
+    size_t suffix = 0;
+    while (prefix + suffix < pattern_length && prefix + suffix < text_length && pattern[pattern_length - 1 - suffix] == text[text_length - 1 - suffix])
+    {
+        ++suffix;
+    }
+    const size_t middle = pattern_length - prefix - suffix;
+    const size_t end = text_length - suffix;
+    if (middle == 0 || prefix == end)
+    {
+        return middle + (end - prefix);
+    }
+
+    // Myers' bit-vector algorithm with Hyyrö's change for the edit distance of the whole strings rather than a substring search. Shifting
+    // out the prefix is enough, bits above the middle of the pattern never reach the highest bit that is read
+    std::uint64_t pv = ~std::uint64_t{0};
+    std::uint64_t mv = 0;
+    const std::uint64_t high = std::uint64_t{1} << (middle - 1);
+    size_t score = middle;
+    for (size_t i = prefix; i < end; ++i)
+    {
+        const std::uint64_t eq = peq[slots[static_cast<unsigned char>(text[i])]] >> prefix;
+        const std::uint64_t xv = eq | mv;
+        const std::uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        std::uint64_t ph = mv | ~(xh | pv);
+        std::uint64_t mh = pv & xh;
+        // Branch free, whether the score goes up or down depends on the text and would be mispredicted often
+        score += static_cast<size_t>((ph & high) != 0) - static_cast<size_t>((mh & high) != 0);
+        // The score drops by at most one per remaining character, stop once the limit is out of reach
+        if (score > limit + (end - i - 1))
+        {
+            return limit + 1;
+        }
+        ph = ph << 1 | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+    return score;
+}
+
+CCLIP_INLINE std::vector<cclip::suggestion> cclip::suggestion_index::find(const std::string_view name, const size_t max_results) const
+{
+    std::vector<suggestion> results;
+    const size_t length = std::min<size_t>(name.size(), 64);
+    if (length == 0 || max_results == 0)
+    {
+        return results;
+    }
+
+    // The positions of each character of the name, through a byte per character so there is less to clear; slot 0 is every other character.
+    // A character seen for the first time takes the next slot without a branch, which would be mispredicted all along the name
+    unsigned char slots[256] = {};
+    std::uint64_t peq[65] = {};
+    size_t used = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+        unsigned char &slot = slots[static_cast<unsigned char>(name[i])];
+        const size_t first = slot == 0;
+        used += first;
+        slot = static_cast<unsigned char>(slot | (used & (0 - first)));
+        peq[slot] |= std::uint64_t{1} << i;
+    }
+
+    const std::uint64_t characters = character_set(name.data(), length);
+    // A third of the length like rustc and cargo, so a short name is not matched with everything that shares a letter or two
+    size_t limit = std::min<size_t>(std::max<size_t>(length, 3) / 3, 3);
+    // Every edit adds or removes at most one distinct character, so a name lacking more than limit of the characters, or having more than
+    // limit others, is too far away; clearing the lowest set bit limit times counts that far without a popcount instruction
+    const auto too_different = [characters, &limit](const std::uint64_t candidate)
+    {
+        std::uint64_t missing = characters & ~candidate;
+        std::uint64_t extra = candidate & ~characters;
+        for (size_t i = 0; i < limit; ++i)
+        {
+            missing &= missing - 1;
+            extra &= extra - 1;
+        }
+        return (missing | extra) != 0;
+    };
+    // The best matches so far with their rank: the distance, then closest in length, longer before shorter, then the order the names were
+    // added in, so the result does not depend on the order the candidates are visited in. Kept on the stack for the usual few results
+    using ranked = std::pair<std::uint64_t, std::uint32_t>;
+    ranked inline_best[8];
+    std::vector<ranked> spilled;
+    ranked *best = inline_best;
+    if (max_results >= std::size(inline_best))
+    {
+        spilled.resize(max_results + 1);
+        best = spilled.data();
+    }
+    size_t best_count = 0;
+    const auto consider = [&](const posting &p)
+    {
+        const size_t difference = p.length >= length ? p.length - length : length - p.length;
+        // Both tests are made before the one branch, most candidates fail one of them and which one is hard to predict
+        if ((difference > limit) | too_different(p.characters))
+        {
+            return;
+        }
+        if (std::any_of(best, best + best_count, [&p](const ranked &b) { return b.second == p.entry; }))
+        {
+            return;
+        }
+        const entry &candidate = this->entries[p.entry];
+        const size_t d = distance(slots, peq, name.data(), length, candidate.name, candidate.length, limit);
+        if (d > limit)
+        {
+            return;
+        }
+        const std::uint64_t order = p.length >= length ? 2 * difference : 2 * difference + 1;
+        const ranked current{std::uint64_t{d} << 56 | order << 32 | p.entry, p.entry};
+        ranked *const same_option = std::find_if(best, best + best_count, [this, &candidate](const ranked &b) { return this->entries[b.second].option == candidate.option; });
+        if (same_option != best + best_count)
+        {
+            if (same_option->first <= current.first)
+            {
+                return;
+            }
+            std::copy(same_option + 1, best + best_count, same_option);
+            --best_count;
+        }
+        ranked *const position = std::upper_bound(best, best + best_count, current);
+        std::copy_backward(position, best + best_count, best + best_count + 1);
+        *position = current;
+        best_count = std::min(best_count + 1, max_results);
+        if (best_count == max_results)
+        {
+            limit = static_cast<size_t>(best[best_count - 1].first >> 56);
+        }
+    };
+    const auto finish = [&]
+    {
+        results.reserve(best_count);
+        for (size_t i = 0; i < best_count; ++i)
+        {
+            const entry &e = this->entries[best[i].second];
+            results.push_back(suggestion{e.name, e.is_long, e.option, static_cast<size_t>(best[i].first >> 56)});
+        }
+        return results;
+    };
+
+    // An edit changes at most one of a set of pieces that do not overlap, so a match contains one of any limit + 1 of them. Pick the bigrams
+    // and trigrams whose posting lists are the shortest in total, a piece that no name has being the best pick
+    const size_t needed = limit + 1;
+    const size_t shortest = length > limit ? length - limit : 1;
+    if (length >= 2 * needed)
+    {
+        // A piece no name has is kept as a slot with an empty list
+        const gram_slot missing{0, 0, 0};
+        const gram_slot *bigrams[63];
+        const gram_slot *trigrams[62];
+        const auto lookup = [this, &missing](const std::uint32_t key)
+        {
+            const size_t position = this->find_gram(key);
+            return position == this->gram_slots.size() ? &missing : &this->gram_slots[position];
+        };
+        // Trigrams alone are enough once the name is long enough for them, which saves half of the lookups. That is from 12 characters on,
+        // so the bigram lists only need the names up to 3 edits longer
+        const bool use_bigrams = length < 3 * needed;
+        size_t cost[65][5]; // the smallest total for j pieces that all end before i
+        const size_t none = ~size_t{0} >> 2;
+        // The lookups do not depend on each other, done apart from the sums they overlap in the pipeline
+        for (size_t i = 0; i + 2 < length; ++i)
+        {
+            trigrams[i] = lookup(gram(name.data() + i, 3));
+        }
+        for (size_t i = 0; use_bigrams && i + 1 < length; ++i)
+        {
+            bigrams[i] = lookup(gram(name.data() + i, 2));
+        }
+        for (size_t i = 0; i <= length; ++i)
+        {
+            cost[i][0] = 0;
+            for (size_t j = 1; j <= needed; ++j)
+            {
+                cost[i][j] = i == 0 ? none : cost[i - 1][j];
+                if (use_bigrams && i >= 2)
+                {
+                    cost[i][j] = std::min(cost[i][j], cost[i - 2][j - 1] + bigrams[i - 2]->size);
+                }
+                if (i >= 3)
+                {
+                    cost[i][j] = std::min(cost[i][j], cost[i - 3][j - 1] + trigrams[i - 3]->size);
+                }
+            }
+        }
+
+        const std::vector<posting> *chosen[4];
+        size_t chosen_count = 0;
+        for (size_t i = length, j = needed; j > 0;)
+        {
+            if (cost[i][j] == cost[i - 1][j])
+            {
+                --i;
+                continue;
+            }
+            const bool is_bigram = use_bigrams && cost[i][j] == cost[i - 2][j - 1] + bigrams[i - 2]->size;
+            const gram_slot *slot = is_bigram ? bigrams[i - 2] : trigrams[i - 3];
+            i -= is_bigram ? 2 : 3;
+            --j;
+            if (slot->size != 0)
+            {
+                chosen[chosen_count++] = &this->postings[slot->list];
+            }
+        }
+        size_t scan_size = 0;
+        for (size_t candidate_length = shortest; candidate_length <= length + limit && candidate_length < this->buckets.size(); ++candidate_length)
+        {
+            scan_size += this->buckets[candidate_length].size();
+        }
+
+        if (cost[length][needed] < scan_size)
+        {
+            // A name in several of the lists is met more than once, which the ranking makes harmless. The lists are short and sorted by
+            // length, so walking up to the longest nearby length is cheaper than searching for the nearby range
+            for (size_t i = 0; i < chosen_count; ++i)
+            {
+                for (const posting &p: *chosen[i])
+                {
+                    if (p.length > length + limit)
+                    {
+                        break;
+                    }
+                    consider(p);
+                }
+            }
+            return finish();
+        }
+    }
+
+    for (size_t offset = 0; offset <= limit; ++offset)
+    {
+        const size_t lengths[2] = {length + offset, length - offset};
+        for (size_t side = 0; side < (offset == 0 ? 1 : 2); ++side)
+        {
+            const size_t candidate_length = lengths[side];
+            if ((side == 1 && offset >= length) || candidate_length >= this->buckets.size())
+            {
+                continue;
+            }
+            for (const posting &p: this->buckets[candidate_length])
+            {
+                consider(p);
+            }
+        }
+    }
+    return finish();
+}
@@ -0,0 +1,194 @@
+#include "utf8.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CCLIP_UTF8_SSE2 1
+#endif
+
+CCLIP_INLINE std::int32_t cclip::detail::decode_utf8(const unsigned char *&position, const unsigned char *end)
+{
+    const unsigned char lead = position[0];
+    if (lead < 0x80)
+    {
+        ++position;
+        return lead;
+    }
+
+    // The lead byte decides the length and the range of the second byte, which rules out overlong encodings, surrogates and code points above U+10FFFF
+    size_t length;
+    unsigned char low = 0x80;
+    unsigned char high = 0xBF;
+    std::int32_t code_point;
+    if (lead < 0xC2)
+    {
+        ++position; // a continuation byte, or an overlong two byte sequence
+        return -1;
+    }
+    if (lead < 0xE0)
+    {
+        length = 2;
+        code_point = lead & 0x1F;
+    } else if (lead < 0xF0)
+    {
+        length = 3;
+        code_point = lead & 0x0F;
+        low = lead == 0xE0 ? 0xA0 : 0x80;
+        high = lead == 0xED ? 0x9F : 0xBF;
+    } else if (lead < 0xF5)
+    {
+        length = 4;
+        code_point = lead & 0x07;
+        low = lead == 0xF0 ? 0x90 : 0x80;
+        high = lead == 0xF4 ? 0x8F : 0xBF;
+    } else
+    {
+        ++position;
+        return -1;
+    }
+    if (static_cast<size_t>(end - position) < length || position[1] < low || position[1] > high)
+    {
+        ++position;
+        return -1;
+    }
+    for (size_t i = 1; i < length; ++i)
+    {
+        if (i > 1 && (position[i] & 0xC0) != 0x80)
+        {
+            ++position;
+            return -1;
+        }
+        code_point = code_point << 6 | (position[i] & 0x3F);
+    }
+    position += length;
+    return code_point;
+}
+
+CCLIP_INLINE size_t cclip::detail::code_point_width(const std::int32_t code_point)
+{
+    struct range
+    {
+        std::int32_t first;
+        std::int32_t last;
+    };
+
+    // Combining marks, format and zero-width characters, variation selectors and emoji modifiers
+    static constexpr range zero_width[] = {
+        {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x05BF, 0x05BF}, {0x05C1, 0x05C2}, {0x05C4, 0x05C5}, {0x05C7, 0x05C7},
+        {0x0610, 0x061A}, {0x064B, 0x065F}, {0x0670, 0x0670}, {0x06D6, 0x06DC}, {0x06DF, 0x06E4}, {0x06E7, 0x06E8}, {0x06EA, 0x06ED},
+        {0x0900, 0x0902}, {0x093A, 0x093A}, {0x093C, 0x093C}, {0x0941, 0x0948}, {0x094D, 0x094D}, {0x0951, 0x0957}, {0x0E31, 0x0E31},
+        {0x0E34, 0x0E3A}, {0x0E47, 0x0E4E}, {0x1160, 0x11FF}, {0x1AB0, 0x1AFF}, {0x1DC0, 0x1DFF}, {0x200B, 0x200F}, {0x202A, 0x202E},
+        {0x2060, 0x2064}, {0x20D0, 0x20FF}, {0x302A, 0x302D}, {0x3099, 0x309A}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F}, {0xFEFF, 0xFEFF},
+        {0x1F3FB, 0x1F3FF}, {0xE0001, 0xE007F}, {0xE0100, 0xE01EF},
+    };
+    // East Asian wide and fullwidth characters and emoji shown in emoji presentation
+    static constexpr range wide[] = {
+        {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC}, {0x23F0, 0x23F0}, {0x23F3, 0x23F3}, {0x25FD, 0x25FE},
+        {0x2614, 0x2615}, {0x2648, 0x2653}, {0x267F, 0x267F}, {0x2693, 0x2693}, {0x26A1, 0x26A1}, {0x26AA, 0x26AB}, {0x26BD, 0x26BE},
+        {0x26C4, 0x26C5}, {0x26CE, 0x26CE}, {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5}, {0x26FA, 0x26FA},
+        {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B}, {0x2728, 0x2728}, {0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755},
+        {0x2757, 0x2757}, {0x2795, 0x2797}, {0x27B0, 0x27B0}, {0x27BF, 0x27BF}, {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55},
+        {0x2E80, 0x303E}, {0x3041, 0x33FF}, {0x3400, 0x4DBF}, {0x4E00, 0x9FFF}, {0xA000, 0xA4CF}, {0xA960, 0xA97F}, {0xAC00, 0xD7A3},
+        {0xF900, 0xFAFF}, {0xFE10, 0xFE19}, {0xFE30, 0xFE6F}, {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x16FE0, 0x16FE4}, {0x17000, 0x18AFF},
+        {0x1B000, 0x1B2FF}, {0x1F004, 0x1F004}, {0x1F0CF, 0x1F0CF}, {0x1F18E, 0x1F18E}, {0x1F191, 0x1F19A}, {0x1F200, 0x1F251},
+        {0x1F300, 0x1F64F}, {0x1F680, 0x1F6FF}, {0x1F7E0, 0x1F7EB}, {0x1F90C, 0x1F9FF}, {0x1FA70, 0x1FAFF}, {0x20000, 0x2FFFD},
+        {0x30000, 0x3FFFD},
+    };
+
+    const auto contains = [code_point](const range *first, const range *end) {
+        // binary search for the first range that ends at or after the code point
+        const range *last = end;
+        while (first < last)
+        {
+            const range *middle = first + (last - first) / 2;
+            if (middle->last < code_point)
+            {
+                first = middle + 1;
+            } else
+            {
+                last = middle;
+            }
+        }
+        return first != end && first->first <= code_point;
+    };
+
+    if (code_point < 0x20 || (code_point >= 0x7F && code_point < 0xA0))
+    {
+        return 0;
+    }
+    if (code_point < 0x300)
+    {
+        return 1;
+    }
+    if (contains(std::begin(zero_width), std::end(zero_width)))
+    {
+        return 0;
+    }
+    return contains(std::begin(wide), std::end(wide)) ? 2 : 1;
+}
+
+CCLIP_INLINE bool cclip::is_valid_utf8(const std::string_view text)
+{
+    const auto *position = reinterpret_cast<const unsigned char *>(text.data());
+    const unsigned char *end = position + text.size();
+#ifdef CCLIP_UTF8_SSE2
+    while (end - position >= 16)
+    {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(position));
+        if (_mm_movemask_epi8(chunk) == 0)
+        {
+            position += 16; // all ASCII
+            continue;
+        }
+        const unsigned char *chunk_end = position + 16;
+        while (position < chunk_end)
+        {
+            if (detail::decode_utf8(position, end) < 0)
+            {
+                return false;
+            }
+        }
+    }
+#endif
+    while (position < end)
+    {
+        if (detail::decode_utf8(position, end) < 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+CCLIP_INLINE size_t cclip::display_width(const std::string_view text)
+{
+    const auto *position = reinterpret_cast<const unsigned char *>(text.data());
+    const unsigned char *end = position + text.size();
+    size_t width = 0;
+#ifdef CCLIP_UTF8_SSE2
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i del = _mm_set1_epi8(0x7F);
+    while (end - position >= 16)
+    {
+        // Bytes below a space compare as less in a signed compare, and so do the bytes of multi-byte sequences, leaving printable ASCII
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(position));
+        if ((_mm_movemask_epi8(_mm_cmplt_epi8(chunk, space)) | _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, del))) == 0)
+        {
+            position += 16;
+            width += 16;
+            continue;
+        }
+        const unsigned char *chunk_end = position + 16;
+        while (position < chunk_end)
+        {
+            const std::int32_t code_point = detail::decode_utf8(position, end);
+            width += code_point < 0 ? 1 : detail::code_point_width(code_point);
+        }
+    }
+#endif
+    while (position < end)
+    {
+        const std::int32_t code_point = detail::decode_utf8(position, end);
+        width += code_point < 0 ? 1 : detail::code_point_width(code_point);
+    }
+    return width;
+}